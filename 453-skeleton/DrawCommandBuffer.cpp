@@ -0,0 +1,56 @@
+#include "DrawCommandBuffer.h"
+
+#include "GLExtensions.h"
+
+
+DrawCommandBuffer::DrawCommandBuffer(size_t commandsPerFrame)
+	: commands{}
+	, stream(commandsPerFrame * sizeof(DrawElementsIndirectCommand))
+{
+	commands.reserve(commandsPerFrame);
+}
+
+
+size_t DrawCommandBuffer::add(const ArenaMesh& mesh, GLuint instanceCount, GLuint baseInstance) {
+	commands.push_back(DrawElementsIndirectCommand{
+		GLuint(mesh.indexCount),
+		instanceCount,
+		GLuint(mesh.indexOffset / sizeof(GLuint)),
+		mesh.baseVertex,
+		baseInstance
+	});
+	return commands.size() - 1;
+}
+
+
+void DrawCommandBuffer::upload() {
+	// the fallback draws straight from the vector
+	if (!isIndirect() || commands.empty()) {
+		return;
+	}
+	base = stream.write(commands.data(), sizeof(DrawElementsIndirectCommand) * commands.size());
+}
+
+
+void DrawCommandBuffer::draw(size_t first, size_t count, InstanceBuffer& instances) const {
+	if (isIndirect()) {
+		// baseInstance is counted from where the attributes point
+		instances.setFirstInstance(0);
+		stream.bind(GL_DRAW_INDIRECT_BUFFER);
+		GLExtensions::multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			(const void*)(base + sizeof(DrawElementsIndirectCommand) * first), GLsizei(count), 0);
+		return;
+	}
+
+	for (size_t i = first; i < first + count; i++) {
+		const DrawElementsIndirectCommand& command = commands[i];
+		instances.setFirstInstance(command.baseInstance);
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, GLsizei(command.count), GL_UNSIGNED_INT,
+			(const void*)(sizeof(GLuint) * command.firstIndex), GLsizei(command.instanceCount), command.baseVertex);
+	}
+}
+
+
+bool DrawCommandBuffer::isIndirect() {
+	return GLExtensions::multiDrawElementsIndirect != nullptr;
+}
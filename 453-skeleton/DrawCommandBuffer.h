@@ -0,0 +1,74 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Draw commands for meshes in the MeshArena, built up on the CPU every frame
+// and submitted a batch at a time.
+//
+// With GL 4.3 (or ARB_multi_draw_indirect) the commands are uploaded to a
+// GL_DRAW_INDIRECT_BUFFER and a whole batch goes out in one
+// glMultiDrawElementsIndirect call, however many meshes and bodies it has.
+// Each command's baseInstance picks its rows of the instance buffer.
+//
+// Plain GL 3.3 has no base instance, so there the same commands are replayed
+// one instanced draw at a time, re-pointing the instance attributes in between.
+//------------------------------------------------------------------------------
+
+#include "InstanceBuffer.h"
+#include "MeshArena.h"
+#include "StreamBuffer.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+
+// Layout glMultiDrawElementsIndirect reads, don't reorder
+struct DrawElementsIndirectCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex; // in indices, not bytes
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "indirect commands are five tightly packed ints");
+
+
+class DrawCommandBuffer {
+
+public:
+	DrawCommandBuffer(size_t commandsPerFrame);
+
+	// Because we're using the StreamBuffer to do RAII for the buffer for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	// Drops last frame's commands
+	void clear() { commands.clear(); }
+
+	// Adds a draw of instanceCount instances of mesh, reading the instance buffer
+	// from row baseInstance on, and returns the command's index
+	size_t add(const ArenaMesh& mesh, GLuint instanceCount, GLuint baseInstance);
+	size_t size() const { return commands.size(); }
+
+	// Copies every command added this frame to the GPU, once they are all in and
+	// before the first draw. Never waits on the GPU, see StreamBuffer
+	void upload();
+
+	// Draws count commands starting at first. The arena VAO of their meshes has
+	// to be bound and instances has to be its instance buffer.
+	void draw(size_t first, size_t count, InstanceBuffer& instances) const;
+
+	// True if draw submits a whole batch with one call
+	static bool isIndirect();
+
+private:
+	std::vector<DrawElementsIndirectCommand> commands;
+	StreamBuffer stream;
+	size_t base = 0; // where the last upload starts in stream
+};
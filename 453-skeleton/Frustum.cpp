@@ -0,0 +1,35 @@
+#include "Frustum.h"
+
+
+Frustum::Frustum(const glm::mat4& PV) {
+	// row i of PV, glm matrices are indexed by column first
+	auto row = [&PV](int i) {
+		return glm::vec4(PV[0][i], PV[1][i], PV[2][i], PV[3][i]);
+	};
+	glm::vec4 x = row(0);
+	glm::vec4 y = row(1);
+	glm::vec4 z = row(2);
+	glm::vec4 w = row(3);
+
+	// a point is on screen when -w <= x, y, z <= w in clip space
+	planes[0] = w + x; // left
+	planes[1] = w - x; // right
+	planes[2] = w + y; // bottom
+	planes[3] = w - y; // top
+	planes[4] = w + z; // near
+	planes[5] = w - z; // far
+
+	for (glm::vec4& plane : planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+}
+
+
+bool Frustum::intersects(const BoundingSphere& sphere) const {
+	for (const glm::vec4& plane : planes) {
+		if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+			return false;
+		}
+	}
+	return true;
+}
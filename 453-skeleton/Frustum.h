@@ -0,0 +1,34 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// The six planes of a camera's view volume, for throwing away anything that
+// can't end up on screen before it is drawn. The planes are pulled straight out
+// of the combined projection and view matrix (Gribb and Hartmann), so they are
+// in world space and match whatever projection the camera uses.
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+
+// Sphere that everything a drawable puts on screen fits inside, in world space
+struct BoundingSphere {
+	glm::vec3 center;
+	float radius;
+};
+
+
+class Frustum {
+
+public:
+	// PV is P * V, world space -> clip space
+	explicit Frustum(const glm::mat4& PV);
+
+	// False only if the sphere is entirely outside one of the planes. Spheres
+	// near a corner can pass without being on screen, which just costs a draw.
+	bool intersects(const BoundingSphere& sphere) const;
+
+private:
+	// xyz is the unit normal pointing inside, w the distance from the origin,
+	// so a point p is inside when dot(xyz, p) + w >= 0
+	glm::vec4 planes[6];
+};
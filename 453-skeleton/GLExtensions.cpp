@@ -0,0 +1,32 @@
+#include "GLExtensions.h"
+
+#include "Log.h"
+
+
+namespace GLExtensions {
+
+	BufferStorageProc bufferStorage = nullptr;
+	MultiDrawElementsIndirectProc multiDrawElementsIndirect = nullptr;
+
+
+	bool hasVersion(int major, int minor) {
+		GLint contextMajor = 0;
+		GLint contextMinor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+		glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+		return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+	}
+
+
+	void load() {
+		if (hasVersion(4, 4) || glfwExtensionSupported("GL_ARB_buffer_storage")) {
+			bufferStorage = reinterpret_cast<BufferStorageProc>(glfwGetProcAddress("glBufferStorage"));
+		}
+		Log::info("GL persistent mapped buffers {}", bufferStorage != nullptr ? "available" : "not available, using orphaning");
+
+		if (hasVersion(4, 3) || (glfwExtensionSupported("GL_ARB_multi_draw_indirect") && glfwExtensionSupported("GL_ARB_base_instance"))) {
+			multiDrawElementsIndirect = reinterpret_cast<MultiDrawElementsIndirectProc>(glfwGetProcAddress("glMultiDrawElementsIndirect"));
+		}
+		Log::info("GL multi draw indirect {}", multiDrawElementsIndirect != nullptr ? "available" : "not available, drawing one command at a time");
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// OpenGL entry points newer than the 3.3 core profile glad loads for us. They
+// are looked up at runtime once a context exists. A null pointer means the
+// driver doesn't have the feature and the caller has to fall back to 3.3.
+//------------------------------------------------------------------------------
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+
+// GL 4.4 / ARB_buffer_storage
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+
+// GL 4.0 / ARB_draw_indirect
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+
+namespace GLExtensions {
+
+	using BufferStorageProc = void (APIENTRY*)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+	using MultiDrawElementsIndirectProc = void (APIENTRY*)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+
+	// null without GL 4.4 or ARB_buffer_storage
+	extern BufferStorageProc bufferStorage;
+	// null without GL 4.3, or ARB_multi_draw_indirect and ARB_base_instance
+	// which the commands need to pick their instances
+	extern MultiDrawElementsIndirectProc multiDrawElementsIndirect;
+
+
+	// Looks everything up for the current context
+	void load();
+
+	// True if the context is at least major.minor
+	bool hasVersion(int major, int minor);
+}
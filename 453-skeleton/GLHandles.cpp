@@ -1,5 +1,7 @@
 #include "GLHandles.h"
 
+#include "GLState.h"
+
 #include <algorithm> // For std::swap
 
 ShaderHandle::ShaderHandle(GLenum type)
@@ -58,6 +60,7 @@ ShaderProgramHandle& ShaderProgramHandle::operator=(ShaderProgramHandle&& other)
 
 
 ShaderProgramHandle::~ShaderProgramHandle() {
+	GLState::forgetProgram(programID);
 	glDeleteProgram(programID);
 }
 
@@ -95,6 +98,7 @@ VertexArrayHandle& VertexArrayHandle::operator=(VertexArrayHandle&& other) noexc
 
 
 VertexArrayHandle::~VertexArrayHandle() {
+	GLState::forgetVertexArray(vaoID);
 	glDeleteVertexArrays(1, &vaoID);
 }
 
@@ -132,6 +136,7 @@ VertexBufferHandle& VertexBufferHandle::operator=(VertexBufferHandle&& other) no
 
 
 VertexBufferHandle::~VertexBufferHandle() {
+	GLState::forgetBuffer(vboID);
 	glDeleteBuffers(1, &vboID);
 }
 
@@ -168,6 +173,7 @@ TextureHandle& TextureHandle::operator=(TextureHandle&& other) noexcept {
 
 
 TextureHandle::~TextureHandle() {
+	GLState::forgetTexture(textureID);
 	glDeleteTextures(1, &textureID);
 }
 
@@ -180,3 +186,39 @@ TextureHandle::operator GLuint() const {
 GLuint TextureHandle::value() const {
 	return textureID;
 }
+
+
+//------------------------------------------------------------------------------
+
+QueryHandle::QueryHandle()
+	: queryID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenQueries(1, &queryID);
+}
+
+
+QueryHandle::QueryHandle(QueryHandle&& other) noexcept
+	: queryID(std::move(other.queryID))
+{
+	other.queryID = 0;
+}
+
+QueryHandle& QueryHandle::operator=(QueryHandle&& other) noexcept {
+	std::swap(queryID, other.queryID);
+	return *this;
+}
+
+
+QueryHandle::~QueryHandle() {
+	glDeleteQueries(1, &queryID);
+}
+
+
+QueryHandle::operator GLuint() const {
+	return queryID;
+}
+
+
+GLuint QueryHandle::value() const {
+	return queryID;
+}
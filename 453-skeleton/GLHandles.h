@@ -184,3 +184,32 @@ private:
 	GLuint textureID;
 
 };
+
+
+// An RAII class for managing a query object GLuint for OpenGL.
+class QueryHandle {
+
+public:
+	QueryHandle();
+
+
+	// Disallow copying
+	QueryHandle(const QueryHandle&) = delete;
+	QueryHandle operator=(const QueryHandle&) = delete;
+
+	// Allow moving
+	QueryHandle(QueryHandle&& other) noexcept;
+	QueryHandle& operator=(QueryHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~QueryHandle();
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint queryID;
+
+};
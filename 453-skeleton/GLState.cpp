@@ -0,0 +1,168 @@
+#include "GLState.h"
+
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+
+namespace GLState {
+
+	namespace {
+		// no GL object has this name, so nothing matches it
+		const GLuint UNKNOWN = ~0u;
+
+		GLuint program = UNKNOWN;
+		GLuint vertexArray = UNKNOWN;
+		GLenum unit = 0; // 0 is unknown, units start at GL_TEXTURE0
+		GLenum polygon = 0;
+		std::unordered_map<GLenum, GLuint> buffers;               // by target
+		std::map<std::pair<GLenum, GLenum>, GLuint> textures;     // by unit and target
+		std::unordered_map<GLenum, bool> capabilities;
+		size_t saved = 0;
+
+
+		// True if the call has to be made, and records value as current
+		bool change(GLuint& current, GLuint value) {
+			if (current == value) {
+				saved++;
+				return false;
+			}
+			current = value;
+			return true;
+		}
+
+		// Entries a missing key creates start out unknown
+		GLuint& entry(std::unordered_map<GLenum, GLuint>& bindings, GLenum key) {
+			return bindings.try_emplace(key, UNKNOWN).first->second;
+		}
+	}
+
+
+	void useProgram(GLuint value) {
+		if (change(program, value)) {
+			glUseProgram(value);
+		}
+	}
+
+
+	void bindVertexArray(GLuint value) {
+		if (change(vertexArray, value)) {
+			glBindVertexArray(value);
+		}
+	}
+
+
+	void bindBuffer(GLenum target, GLuint buffer) {
+		if (target == GL_ELEMENT_ARRAY_BUFFER) {
+			glBindBuffer(target, buffer);
+			return;
+		}
+		if (change(entry(buffers, target), buffer)) {
+			glBindBuffer(target, buffer);
+		}
+	}
+
+
+	void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+		glBindBufferRange(target, index, buffer, offset, size);
+		entry(buffers, target) = buffer;
+	}
+
+
+	void activeTexture(GLenum value) {
+		if (change(unit, value)) {
+			glActiveTexture(value);
+		}
+	}
+
+
+	void bindTexture(GLenum target, GLuint texture) {
+		// GL starts out on unit 0
+		if (unit == 0) {
+			activeTexture(GL_TEXTURE0);
+		}
+		GLuint& current = textures.try_emplace({ unit, target }, UNKNOWN).first->second;
+		if (change(current, texture)) {
+			glBindTexture(target, texture);
+		}
+	}
+
+
+	void enable(GLenum capability) {
+		auto found = capabilities.find(capability);
+		if (found != capabilities.end() && found->second) {
+			saved++;
+			return;
+		}
+		capabilities[capability] = true;
+		glEnable(capability);
+	}
+
+
+	void disable(GLenum capability) {
+		auto found = capabilities.find(capability);
+		if (found != capabilities.end() && !found->second) {
+			saved++;
+			return;
+		}
+		capabilities[capability] = false;
+		glDisable(capability);
+	}
+
+
+	void polygonMode(GLenum mode) {
+		if (change(polygon, mode)) {
+			glPolygonMode(GL_FRONT_AND_BACK, mode);
+		}
+	}
+
+
+	// A deleted program stays current until another one is used, so only
+	// forget it. Everything else GL unbinds, leaving 0 behind.
+	void forgetProgram(GLuint value) {
+		if (program == value) {
+			program = UNKNOWN;
+		}
+	}
+
+
+	void forgetVertexArray(GLuint value) {
+		if (vertexArray == value) {
+			vertexArray = 0;
+		}
+	}
+
+
+	void forgetBuffer(GLuint buffer) {
+		for (auto& binding : buffers) {
+			if (binding.second == buffer) {
+				binding.second = 0;
+			}
+		}
+	}
+
+
+	void forgetTexture(GLuint texture) {
+		for (auto& binding : textures) {
+			if (binding.second == texture) {
+				binding.second = 0;
+			}
+		}
+	}
+
+
+	void reset() {
+		program = UNKNOWN;
+		vertexArray = UNKNOWN;
+		unit = 0;
+		polygon = 0;
+		buffers.clear();
+		textures.clear();
+		capabilities.clear();
+	}
+
+
+	size_t takeSavedCalls() {
+		return std::exchange(saved, 0);
+	}
+}
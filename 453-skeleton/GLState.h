@@ -0,0 +1,52 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Remembers the GL state the wrapper classes set, the current program, VAO,
+// buffer bindings, texture units, enable bits and polygon mode, and drops any
+// call that would set something to what it already is.
+//
+// This only works if every call that changes that state goes through here,
+// so the wrappers do, and the handles in GLHandles.h tell it when an object is
+// deleted since GL unbinds it and may hand its name out again. Code outside
+// the wrappers that changes state behind its back (imgui, for one) has to call
+// reset() afterwards.
+//
+// Not tracked: GL_ELEMENT_ARRAY_BUFFER, which is part of the VAO, and the
+// indexed buffer bindings, which only glBindBufferRange sets.
+//------------------------------------------------------------------------------
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstddef>
+
+
+namespace GLState {
+
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vertexArray);
+	void bindBuffer(GLenum target, GLuint buffer);
+	// Also sets the generic binding of target, like glBindBufferRange does
+	void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	void activeTexture(GLenum unit);
+	// To the active texture unit
+	void bindTexture(GLenum target, GLuint texture);
+
+	void enable(GLenum capability);
+	void disable(GLenum capability);
+	void polygonMode(GLenum mode); // for GL_FRONT_AND_BACK, the only face core allows
+
+	// Called by the handles as the object is deleted
+	void forgetProgram(GLuint program);
+	void forgetVertexArray(GLuint vertexArray);
+	void forgetBuffer(GLuint buffer);
+	void forgetTexture(GLuint texture);
+
+	// Forgets everything, the next call of each kind goes through
+	void reset();
+
+	// Number of calls dropped since the last time this was called,
+	// call it once per frame for a per-frame count
+	size_t takeSavedCalls();
+}
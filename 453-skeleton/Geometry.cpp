@@ -3,23 +3,34 @@
 #include <utility>
 
 
-GPU_Geometry::GPU_Geometry()
+namespace {
+	// Attribute setup happens in the VertexBuffer constructor, which needs
+	// the layout type, so pick it here
+	VertexBuffer makeVertexBuffer(VertexFormat format) {
+		switch (format) {
+		case VertexFormat::Packed:
+			return VertexBuffer(PackedLayout{});
+		case VertexFormat::PackedUnitSphere:
+			return VertexBuffer(UnitSphereLayout{});
+		default:
+			return VertexBuffer(FloatLayout{});
+		}
+	}
+}
+
+
+GPU_Geometry::GPU_Geometry(VertexFormat format)
 	: vao()
-	, vertBuffer(0, 3, GL_FLOAT)
-	, colorsBuffer(1, 2, GL_FLOAT)
-	, normalsBuffer(2, 3, GL_FLOAT)
+	, format(format)
+	, vertexBuffer(makeVertexBuffer(format))
+	, indexBuffer()
 {}
 
 
-void GPU_Geometry::setVerts(const std::vector<glm::vec3>& verts) {
-	vertBuffer.uploadData(sizeof(glm::vec3) * verts.size(), verts.data(), GL_STATIC_DRAW);
+void GPU_Geometry::upload(const CPU_Geometry& geom) {
+	std::vector<unsigned char> vertices = interleave(geom, format);
+	vertexBuffer.uploadData(vertices.size(), vertices.data(), GL_STATIC_DRAW);
+	indexBuffer.uploadData(sizeof(GLuint) * geom.indices.size(), geom.indices.data(), GL_STATIC_DRAW);
 }
 
 
-void GPU_Geometry::setCols(const std::vector<glm::vec2>& cols) {
-	colorsBuffer.uploadData(sizeof(glm::vec2) * cols.size(), cols.data(), GL_STATIC_DRAW);
-}
-
-void GPU_Geometry::setNormals(const std::vector<glm::vec3>& norms) {
-	normalsBuffer.uploadData(sizeof(glm::vec3) * norms.size(), norms.data(), GL_STATIC_DRAW);
-}
@@ -6,8 +6,10 @@
 // similar classes with the needed functionality
 //------------------------------------------------------------------------------
 
+#include "IndexBuffer.h"
 #include "VertexArray.h"
 #include "VertexBuffer.h"
+#include "VertexFormat.h"
 
 //#include <GL/glew.h>
 #include <glad/glad.h>
@@ -18,32 +20,38 @@
 
 
 // List of vertices and texture coordinates using std::vector and glm::vec3
+// indices is optional, when it is empty the vertices are drawn in order
 struct CPU_Geometry {
 	std::vector<glm::vec3> verts;
 	std::vector<glm::vec2> cols;
 	std::vector<glm::vec3> normals;
+	std::vector<GLuint> indices;
 };
 
 
-// VAO and two VBOs for storing vertices and texture coordinates, respectively
+// VAO, one VBO storing vertices, texture coordinates and normals interleaved,
+// and an element buffer for indexed drawing
 class GPU_Geometry {
 
 public:
-	GPU_Geometry();
+	// The vertex buffer is laid out in format, attribute locations 0/1/2.
+	// PackedUnitSphere is only valid for the unit sphere centered on the origin.
+	GPU_Geometry(VertexFormat format = VertexFormat::Float);
 
 	// Public interface
 	void bind() { vao.bind(); }
+	VertexFormat getFormat() const { return format; }
+
+	// Uploads all vertex attributes of geom with a single call, and its indices
+	void upload(const CPU_Geometry& geom);
 
-	void setVerts(const std::vector<glm::vec3>& verts);
-	void setCols(const std::vector<glm::vec2>& cols);
-	void setNormals(const std::vector<glm::vec3>& norms);
 
 private:
 	// note: due to how OpenGL works, vao needs to be
 	// defined and initialized before the vertex buffers
 	VertexArray vao;
 
-	VertexBuffer vertBuffer;
-	VertexBuffer colorsBuffer;
-	VertexBuffer normalsBuffer;
+	VertexFormat format;
+	VertexBuffer vertexBuffer;
+	IndexBuffer indexBuffer;
 };
@@ -0,0 +1,58 @@
+#include "GeometryBuilder.h"
+
+#include <algorithm>
+
+
+GeometryBuilder::~GeometryBuilder() {
+	wait();
+}
+
+
+size_t GeometryBuilder::add(Generator generator) {
+	generators.push_back(std::move(generator));
+	return generators.size() - 1;
+}
+
+
+void GeometryBuilder::start() {
+	// every slot is sized up front so the workers only ever write their own
+	results.resize(generators.size());
+	errors.resize(generators.size());
+
+	size_t count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), generators.size());
+	workers.reserve(count);
+	for (size_t i = 0; i < count; i++) {
+		workers.emplace_back(&GeometryBuilder::work, this);
+	}
+}
+
+
+CPU_Geometry GeometryBuilder::take(size_t ticket) {
+	wait();
+	if (errors[ticket]) {
+		std::rethrow_exception(errors[ticket]);
+	}
+	return std::move(results[ticket]);
+}
+
+
+void GeometryBuilder::work() {
+	// workers pull generators in order until there are none left, so one slow
+	// mesh does not hold up the others queued behind it
+	for (size_t i = next++; i < generators.size(); i = next++) {
+		try {
+			results[i] = generators[i]();
+		}
+		catch (...) {
+			errors[i] = std::current_exception();
+		}
+	}
+}
+
+
+void GeometryBuilder::wait() {
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Builds CPU_Geometry on worker threads. Generators are queued on the GL
+// thread, which can then go on loading textures and compiling shaders while
+// the meshes are made, and takes the results back with take() to upload them.
+// Generators must not make any OpenGL calls.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+
+class GeometryBuilder {
+
+public:
+	using Generator = std::function<CPU_Geometry()>;
+
+	GeometryBuilder() = default;
+	~GeometryBuilder();
+
+	// Because the workers hold a pointer to the builder
+	GeometryBuilder(const GeometryBuilder&) = delete;
+	GeometryBuilder operator=(const GeometryBuilder&) = delete;
+
+	// Queues a generator, the returned ticket is passed to take(). Only valid before start()
+	size_t add(Generator generator);
+
+	// Starts the workers, at most one per hardware thread
+	void start();
+
+	// Waits for every generator to finish and moves out the result of ticket.
+	// Rethrows anything a generator threw.
+	CPU_Geometry take(size_t ticket);
+
+private:
+	void work();
+	void wait();
+
+	std::vector<Generator> generators;
+	std::vector<CPU_Geometry> results;
+	std::vector<std::exception_ptr> errors;
+	std::atomic<size_t> next{ 0 };
+	std::vector<std::thread> workers;
+};
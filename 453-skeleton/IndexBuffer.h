@@ -0,0 +1,34 @@
+#pragma once
+
+#include "GLHandles.h"
+#include "GLState.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+
+class IndexBuffer {
+
+public:
+	IndexBuffer();
+
+	// Because we're using the VertexBufferHandle to do RAII for the buffer for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	// note: the element array binding is part of the VAO state, so the VAO
+	// that should use this buffer has to be bound when this is called
+	void bind() const { GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferID); }
+
+	void uploadData(GLsizeiptr size, const void* data, GLenum usage);
+
+private:
+	// Buffer objects are the same GL type whatever they are bound to,
+	// so the vertex buffer handle does the RAII for us here too
+	VertexBufferHandle bufferID;
+};
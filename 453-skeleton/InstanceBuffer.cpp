@@ -0,0 +1,59 @@
+#include "InstanceBuffer.h"
+
+#include <cstring>
+#include <utility>
+
+
+InstanceBuffer::InstanceBuffer(GLuint index)
+	: stream(64 * sizeof(glm::mat4))
+	, index(index)
+	, base(0)
+	, materialBase(0)
+{
+	bind();
+	for (GLuint i = 0; i < 5; i++) {
+		glEnableVertexAttribArray(index + i);
+		// advance once per instance instead of once per vertex
+		glVertexAttribDivisor(index + i, 1);
+	}
+	setFirstInstance(0);
+}
+
+
+void InstanceBuffer::uploadData(const std::vector<glm::mat4>& matrices, const std::vector<glm::vec2>& materials) {
+	// one write, a second one could land in a new buffer object if the stream grows
+	size_t matrixBytes = sizeof(glm::mat4) * matrices.size();
+	std::vector<unsigned char> data(matrixBytes + sizeof(glm::vec2) * materials.size());
+	std::memcpy(data.data(), matrices.data(), matrixBytes);
+	std::memcpy(data.data() + matrixBytes, materials.data(), data.size() - matrixBytes);
+
+	base = stream.write(data.data(), data.size());
+	materialBase = base + matrixBytes;
+}
+
+
+void InstanceBuffer::setFirstInstance(GLuint first) {
+	readFrom(*this, first);
+}
+
+
+void InstanceBuffer::readFrom(const InstanceBuffer& source, GLuint first) {
+	source.bind();
+	GLsizeiptr offset = source.base + sizeof(glm::mat4) * first;
+
+	for (GLuint i = 0; i < 4; i++) {
+		// each column of the matrix is its own vec4 attribute
+		glVertexAttribPointer(index + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(offset + sizeof(glm::vec4) * i));
+	}
+	GLsizeiptr materialOffset = source.materialBase + sizeof(glm::vec2) * first;
+	glVertexAttribPointer(index + 4, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)materialOffset);
+}
+
+
+void InstanceBuffer::readInterleaved(GLuint buffer, size_t offset, GLsizei stride) {
+	GLState::bindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (GLuint i = 0; i < 4; i++) {
+		glVertexAttribPointer(index + i, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + sizeof(glm::vec4) * i));
+	}
+	glVertexAttribPointer(index + 4, 2, GL_FLOAT, GL_FALSE, stride, (void*)(offset + sizeof(glm::mat4)));
+}
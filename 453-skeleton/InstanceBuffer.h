@@ -0,0 +1,58 @@
+#pragma once
+
+#include "StreamBuffer.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// A vertex buffer holding one model matrix and one material per instance,
+// rewritten every frame. The material is a vec2 of the texture array layer and
+// the sun flag, so bodies with different textures can share a draw.
+//
+// A mat4 attribute takes up four attribute slots, starting at the index
+// given to the constructor, and the material takes the slot after them. Like
+// VertexBuffer, the attribute setup is stored in whichever VAO is bound when
+// this is constructed.
+class InstanceBuffer {
+
+public:
+	InstanceBuffer(GLuint index);
+
+	// Because we're using the StreamBuffer to do RAII for the buffer for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	void bind() const { stream.bind(GL_ARRAY_BUFFER); }
+	// Never waits on the GPU, see StreamBuffer
+	void uploadData(const std::vector<glm::mat4>& matrices, const std::vector<glm::vec2>& materials);
+
+	// Makes instance 0 of the next draw read the matrix at position first of
+	// the last upload. GL 3.3 has no base instance for draws, so the attributes
+	// are re-pointed instead. The VAO that owns this buffer has to be bound.
+	void setFirstInstance(GLuint first);
+
+	// Makes the instances come from buffer instead, as interleaved records of a
+	// matrix followed by a material, stride bytes apart from offset on, which is
+	// what InstanceCuller writes. Undone by the next setFirstInstance.
+	void readInterleaved(GLuint buffer, size_t offset, GLsizei stride);
+
+	// Makes the instances come from the last upload of source instead, from
+	// position first on, so another VAO's instances can be drawn with this one.
+	// Undone by the next setFirstInstance.
+	void readFrom(const InstanceBuffer& source, GLuint first);
+
+private:
+	StreamBuffer stream;
+	GLuint index;
+	size_t base;         // where the last upload's matrices start in stream
+	size_t materialBase; // and where its materials start
+};
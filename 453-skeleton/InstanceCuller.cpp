@@ -0,0 +1,84 @@
+#include "InstanceCuller.h"
+
+#include "GLState.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+InstanceCuller::InstanceCuller()
+	: program("shaders/cull.vert", "shaders/cull.geom", { "culledM", "culledMaterial" })
+	, vao()
+	, input(64 * sizeof(glm::mat4))
+	, output()
+{
+	// the new VAO is still bound, the pointers are set with every upload
+	for (GLuint i = 0; i < 5; i++) {
+		glEnableVertexAttribArray(i);
+	}
+}
+
+
+void InstanceCuller::uploadData(const std::vector<glm::mat4>& matrices, const std::vector<glm::vec2>& materials) {
+	firsts.clear();
+
+	// one write, see InstanceBuffer::uploadData
+	size_t matrixBytes = sizeof(glm::mat4) * matrices.size();
+	std::vector<unsigned char> data(matrixBytes + sizeof(glm::vec2) * materials.size());
+	std::memcpy(data.data(), matrices.data(), matrixBytes);
+	std::memcpy(data.data() + matrixBytes, materials.data(), data.size() - matrixBytes);
+	size_t base = input.write(data.data(), data.size());
+
+	// one point per instance, so the attributes advance per vertex
+	vao.bind();
+	input.bind(GL_ARRAY_BUFFER);
+	for (GLuint i = 0; i < 4; i++) {
+		glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(base + sizeof(glm::vec4) * i));
+	}
+	glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)(base + matrixBytes));
+
+	// reallocating keeps the name, and GL finishes last frame's draws from the
+	// old storage before this frame's culling writes to the new one
+	if (matrices.size() > outputCapacity) {
+		outputCapacity = std::max(matrices.size(), 2 * outputCapacity);
+		GLState::bindBuffer(GL_COPY_WRITE_BUFFER, output);
+		glBufferData(GL_COPY_WRITE_BUFFER, CULLED_INSTANCE_STRIDE * outputCapacity, nullptr, GL_STREAM_COPY);
+	}
+}
+
+
+size_t InstanceCuller::cull(GLuint first, GLuint count, float boundingRadius) {
+	size_t batch = firsts.size();
+	firsts.push_back(first);
+	if (queries.size() <= batch) {
+		queries.emplace_back();
+	}
+
+	program.use();
+	program.setUniform("boundingRadius", boundingRadius);
+	vao.bind();
+	GLState::bindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, output,
+		GLintptr(CULLED_INSTANCE_STRIDE) * first, GLsizeiptr(CULLED_INSTANCE_STRIDE) * count);
+
+	GLState::enable(GL_RASTERIZER_DISCARD);
+	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, queries[batch]);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, GLint(first), GLsizei(count));
+	glEndTransformFeedback();
+	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+	GLState::disable(GL_RASTERIZER_DISCARD);
+
+	return batch;
+}
+
+
+GLuint InstanceCuller::visibleCount(size_t batch) const {
+	GLuint count = 0;
+	glGetQueryObjectuiv(queries[batch], GL_QUERY_RESULT, &count);
+	return count;
+}
+
+
+void InstanceCuller::bindOutput(size_t batch, InstanceBuffer& instances) const {
+	instances.readInterleaved(output, CULLED_INSTANCE_STRIDE * size_t(firsts[batch]), CULLED_INSTANCE_STRIDE);
+}
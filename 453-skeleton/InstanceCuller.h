@@ -0,0 +1,75 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Frustum culling of instances on the GPU with GL 3.3 transform feedback.
+//
+// A frame's instance matrices and materials are uploaded once, unculled. Each
+// batch of them (one instance group) is then run through shaders/cull.vert and
+// cull.geom as points with the rasterizer off: the vertex shader tests the
+// instance's bounding sphere against the frustum from the Frame block, and the
+// geometry shader only emits the visible ones, so transform feedback packs
+// them together in the output buffer. A GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN
+// query per batch counts them, and that count is the instanced draw's.
+//
+// GL 3.3 can't feed the count into a draw without the CPU, so visibleCount
+// reads the query back. Batches are all culled before the first draw, so by
+// the time a draw asks, the GPU has normally finished culling.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "InstanceBuffer.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include "VertexArray.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// One instance in the output, a mat4 and the vec2 material interleaved
+const GLsizei CULLED_INSTANCE_STRIDE = sizeof(glm::mat4) + sizeof(glm::vec2);
+
+
+class InstanceCuller {
+
+public:
+	InstanceCuller();
+
+	// Because we're using the handles to do RAII for the buffers and queries for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	// Every instance of the frame, in one upload like InstanceBuffer::uploadData.
+	// Starts a new frame's batches.
+	void uploadData(const std::vector<glm::mat4>& matrices, const std::vector<glm::vec2>& materials);
+
+	// Culls count instances of the upload from first on, for a mesh that fits in
+	// a sphere of boundingRadius around its origin, and returns the batch. The
+	// survivors are packed at the start of the same rows of the output. The Frame
+	// uniform block has to be bound.
+	size_t cull(GLuint first, GLuint count, float boundingRadius);
+
+	// How many instances of batch survived, waits for the GPU if it isn't done
+	GLuint visibleCount(size_t batch) const;
+
+	// Points instances at the survivors of batch. The VAO that owns it has to be bound.
+	void bindOutput(size_t batch, InstanceBuffer& instances) const;
+
+private:
+	ShaderProgram program;
+	VertexArray vao;
+	StreamBuffer input;
+	VertexBufferHandle output;
+	size_t outputCapacity = 0; // in instances
+
+	std::vector<GLuint> firsts;      // per batch this frame
+	std::vector<QueryHandle> queries; // kept from frame to frame, one per batch
+};
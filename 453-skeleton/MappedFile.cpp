@@ -0,0 +1,91 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) {
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+		HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (fileMapping != nullptr) {
+			// the view keeps the mapping and the file alive once they are closed
+			mapping = static_cast<const unsigned char*>(MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0));
+			length = mapping != nullptr ? size_t(size.QuadPart) : 0;
+			CloseHandle(fileMapping);
+		}
+	}
+	CloseHandle(file);
+}
+
+
+void MappedFile::unmap() {
+	if (mapping != nullptr) {
+		UnmapViewOfFile(mapping);
+	}
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		return;
+	}
+	struct stat info;
+	if (fstat(file, &info) == 0 && info.st_size > 0) {
+		void* view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		if (view != MAP_FAILED) {
+			mapping = static_cast<const unsigned char*>(view);
+			length = size_t(info.st_size);
+		}
+	}
+	// the mapping stays valid after the descriptor is closed
+	close(file);
+}
+
+
+void MappedFile::unmap() {
+	if (mapping != nullptr) {
+		munmap(const_cast<unsigned char*>(mapping), length);
+	}
+}
+
+#endif
+
+
+MappedFile::~MappedFile() {
+	unmap();
+}
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: mapping(std::exchange(other.mapping, nullptr))
+	, length(std::exchange(other.length, 0))
+{}
+
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		unmap();
+		mapping = std::exchange(other.mapping, nullptr);
+		length = std::exchange(other.length, 0);
+	}
+	return *this;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Read only memory mapping of a whole file. The operating system pages the file
+// in as the mapping is read, so its data can go to the GPU without first being
+// copied into a buffer of our own.
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <string>
+
+
+class MappedFile {
+
+public:
+	// Maps the file at path, isOpen() is false if it can't be opened or is empty
+	MappedFile(const std::string& path);
+	~MappedFile();
+
+	// Moving is fine, copying would unmap the file twice
+	MappedFile(const MappedFile&) = delete;
+	MappedFile operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// Public interface
+	bool isOpen() const { return mapping != nullptr; }
+	const unsigned char* data() const { return mapping; }
+	size_t size() const { return length; }
+
+private:
+	void unmap();
+
+	const unsigned char* mapping = nullptr;
+	size_t length = 0;
+};
@@ -0,0 +1,105 @@
+#include "MeshArena.h"
+
+#include "GLState.h"
+
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+
+MeshArena::MeshArena(size_t vertexCapacity, size_t indexCapacity)
+	: vertexBuffer{}
+	, indexBuffer{}
+	, vertexCapacity(vertexCapacity)
+	, indexCapacity(indexCapacity)
+{
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity, nullptr, GL_STATIC_DRAW);
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity, nullptr, GL_STATIC_DRAW);
+}
+
+
+ArenaMesh MeshArena::add(const CPU_Geometry& geom, VertexFormat format) {
+	std::vector<unsigned char> vertices = interleave(geom, format);
+	return add(format, vertices.data(), vertices.size(), geom.indices.data(), geom.indices.size());
+}
+
+
+ArenaMesh MeshArena::add(VertexFormat format, const void* vertices, size_t vertexBytes, const GLuint* indices, size_t indexCount) {
+	// start on a whole vertex of this format so the base vertex can reach it
+	size_t stride = size_t(vertexStride(format));
+	size_t vertexOffset = (vertexUsed + stride - 1) / stride * stride;
+	size_t indexBytes = sizeof(GLuint) * indexCount;
+
+	reserve(vertexBuffer, vertexCapacity, vertexUsed, vertexOffset + vertexBytes);
+	reserve(indexBuffer, indexCapacity, indexUsed, indexUsed + indexBytes);
+
+	// the copy targets leave the VAO bindings alone
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, vertexOffset, vertexBytes, vertices);
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, indexUsed, indexBytes, indices);
+
+	ArenaMesh mesh;
+	mesh.format = format;
+	mesh.baseVertex = GLint(vertexOffset / stride);
+	mesh.indexCount = GLsizei(indexCount);
+	mesh.indexOffset = indexUsed;
+
+	vertexUsed = vertexOffset + vertexBytes;
+	indexUsed += indexBytes;
+	return mesh;
+}
+
+
+void MeshArena::bind(VertexFormat format) {
+	binding(format).vao.bind();
+}
+
+
+const VertexArray& MeshArena::vertexArray(VertexFormat format) {
+	return binding(format).vao;
+}
+
+
+InstanceBuffer& MeshArena::instances(VertexFormat format) {
+	return binding(format).instances;
+}
+
+
+MeshArena::Binding& MeshArena::binding(VertexFormat format) {
+	std::unique_ptr<Binding>& found = bindings[format];
+	if (!found) {
+		found = std::make_unique<Binding>();
+		// the new VAO is still bound
+		GLState::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		setAttribPointers(format);
+		GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	}
+	return *found;
+}
+
+
+void MeshArena::reserve(VertexBufferHandle& buffer, size_t& capacity, size_t used, size_t needed) {
+	if (needed <= capacity) {
+		return;
+	}
+	size_t grown = std::max(needed, 2 * capacity);
+
+	// Reallocating keeps the buffer's name, so every VAO still points at it,
+	// but loses the contents, so they take a round trip through a scratch buffer
+	VertexBufferHandle scratch;
+	GLState::bindBuffer(GL_COPY_READ_BUFFER, buffer);
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+	glBufferData(GL_COPY_WRITE_BUFFER, used, nullptr, GL_STATIC_COPY);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+
+	GLState::bindBuffer(GL_COPY_READ_BUFFER, scratch);
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, grown, nullptr, GL_STATIC_DRAW);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+
+	capacity = grown;
+}
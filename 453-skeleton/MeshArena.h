@@ -0,0 +1,91 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// One vertex buffer and one index buffer that every static mesh is
+// sub-allocated from. Meshes are drawn with the base vertex and index offset of
+// their allocation, so switching between them needs no new bindings at all.
+//
+// A VAO can only describe one vertex layout, so the arena keeps one VAO per
+// VertexFormat in use, all reading the same two buffers. Every allocation
+// starts on a multiple of its format's stride, which lets each of those VAOs
+// point its attributes at offset 0 and reach any mesh through the base vertex.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+#include "GLHandles.h"
+#include "InstanceBuffer.h"
+#include "VertexArray.h"
+#include "VertexFormat.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <map>
+#include <memory>
+
+
+// Where a mesh lives in the arena, what glDrawElementsBaseVertex needs
+struct ArenaMesh {
+	VertexFormat format = VertexFormat::Float;
+	GLint baseVertex = 0;
+	GLsizei indexCount = 0;
+	size_t indexOffset = 0; // in bytes
+
+	const void* indices() const { return (const void*)indexOffset; }
+};
+
+
+class MeshArena {
+
+public:
+	// Capacities are in bytes, the buffers grow past them if they have to
+	MeshArena(size_t vertexCapacity, size_t indexCapacity);
+
+	// Because we're using the VertexBufferHandle to do RAII for the buffer for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Copies a mesh in, geom is interleaved in format first
+	ArenaMesh add(const CPU_Geometry& geom, VertexFormat format);
+	// Same for vertices that are already interleaved in format
+	ArenaMesh add(VertexFormat format, const void* vertices, size_t vertexBytes, const GLuint* indices, size_t indexCount);
+
+	// Binds the VAO that reads meshes stored in format
+	void bind(VertexFormat format);
+	// The same VAO, for binding it later
+	const VertexArray& vertexArray(VertexFormat format);
+
+
+	// Per-instance model matrices at attribute locations 3 to 6 of the VAO of format,
+	// and materials at 7
+	InstanceBuffer& instances(VertexFormat format);
+
+	size_t vertexBytesUsed() const { return vertexUsed; }
+	size_t indexBytesUsed() const { return indexUsed; }
+
+private:
+	// note: the VAO binds itself when constructed, which is
+	// where the instance buffer then sets up its attributes
+	struct Binding {
+		VertexArray vao;
+		InstanceBuffer instances{ 3 };
+	};
+
+
+	Binding& binding(VertexFormat format);
+	void reserve(VertexBufferHandle& buffer, size_t& capacity, size_t used, size_t needed);
+
+	VertexBufferHandle vertexBuffer;
+	VertexBufferHandle indexBuffer;
+	size_t vertexCapacity;
+	size_t indexCapacity;
+	size_t vertexUsed = 0;
+	size_t indexUsed = 0;
+
+	// created the first time a format is bound, unique_ptr since VAOs can't move
+	std::map<VertexFormat, std::unique_ptr<Binding>> bindings;
+};
@@ -0,0 +1,152 @@
+#include "MeshCache.h"
+
+#include "Log.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+
+namespace {
+
+	const char MAGIC[4] = { 'M', 'E', 'S', 'H' };
+
+	// Start of every cache file, followed by paramCount floats, the vertices
+	// and the indices. Everything is a multiple of 4 bytes long so the indices
+	// come out aligned in the mapping.
+	struct MeshFileHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t keyHash;
+		uint32_t format;
+		uint32_t stride;
+		uint32_t paramCount;
+		uint32_t indexCount;
+		uint64_t vertexBytes;
+		float boundingRadius;
+		uint32_t padding;
+	};
+
+	static_assert(sizeof(MeshFileHeader) % 4 == 0, "mesh data after the header must stay 4 byte aligned");
+
+	// FNV-1a, stable between runs unlike std::hash
+	uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
+
+
+uint64_t MeshKey::hash() const {
+	uint64_t hash = 14695981039346656037ull;
+	hash = fnv1a(hash, generator.data(), generator.size());
+	uint32_t f = uint32_t(format);
+	hash = fnv1a(hash, &f, sizeof(f));
+	hash = fnv1a(hash, params.data(), sizeof(float) * params.size());
+	return hash;
+}
+
+
+CachedMesh::CachedMesh(MappedFile file, size_t dataOffset, size_t vertexBytes, size_t indexCount, float boundingRadius)
+	: file(std::move(file))
+	, dataOffset(dataOffset)
+	, verticesSize(vertexBytes)
+	, indicesCount(indexCount)
+	, radius(boundingRadius)
+{}
+
+
+MeshCache::MeshCache(std::string directory)
+	: directory(std::move(directory))
+{}
+
+
+std::optional<CachedMesh> MeshCache::load(const MeshKey& key) const {
+	std::string path = pathFor(key);
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		return std::nullopt;
+	}
+
+	MeshFileHeader header;
+	if (file.size() < sizeof(header)) {
+		Log::warn("MESH CACHE {} is truncated, regenerating", path);
+		return std::nullopt;
+	}
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	size_t paramBytes = sizeof(float) * key.params.size();
+	size_t dataOffset = sizeof(header) + paramBytes;
+	bool valid = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+		&& header.version == MESH_CACHE_VERSION
+		&& header.keyHash == key.hash()
+		&& header.format == uint32_t(key.format)
+		&& header.stride == uint32_t(vertexStride(key.format))
+		&& header.paramCount == key.params.size()
+		&& header.vertexBytes % header.stride == 0
+		&& file.size() == dataOffset + header.vertexBytes + sizeof(GLuint) * size_t(header.indexCount)
+		&& std::memcmp(file.data() + sizeof(header), key.params.data(), paramBytes) == 0;
+	if (!valid) {
+		Log::info("MESH CACHE {} is out of date, regenerating", path);
+		return std::nullopt;
+	}
+
+	return CachedMesh(std::move(file), dataOffset, size_t(header.vertexBytes), header.indexCount, header.boundingRadius);
+}
+
+
+void MeshCache::store(const MeshKey& key, const CPU_Geometry& geom) const {
+	std::vector<unsigned char> vertices = interleave(geom, key.format);
+
+	MeshFileHeader header = {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = MESH_CACHE_VERSION;
+	header.keyHash = key.hash();
+	header.format = uint32_t(key.format);
+	header.stride = uint32_t(vertexStride(key.format));
+	header.paramCount = uint32_t(key.params.size());
+	header.indexCount = uint32_t(geom.indices.size());
+	header.vertexBytes = vertices.size();
+	for (glm::vec3 const& v : geom.verts) {
+		header.boundingRadius = std::max(header.boundingRadius, glm::length(v));
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	// written next to the real file and renamed over it, so a run that stops
+	// half way never leaves a partial file behind to be mapped next time
+	std::string path = pathFor(key);
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(key.params.data()), sizeof(float) * key.params.size());
+		out.write(reinterpret_cast<const char*>(vertices.data()), vertices.size());
+		out.write(reinterpret_cast<const char*>(geom.indices.data()), sizeof(GLuint) * geom.indices.size());
+		if (!out) {
+			std::remove(temporary.c_str());
+			return;
+		}
+	}
+	std::filesystem::rename(temporary, path, error);
+	if (error) {
+		std::remove(temporary.c_str());
+	}
+}
+
+
+std::string MeshCache::pathFor(const MeshKey& key) const {
+	char hash[17];
+	std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(key.hash()));
+	return directory + "/" + key.generator + "-" + hash + ".mesh";
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// On disk cache of generated meshes. Each file holds one mesh already
+// interleaved in its vertex format plus its indices, so a cached mesh is
+// memory mapped and handed to OpenGL as is, without running its generator.
+// Files are named by a hash of the generator and its parameters and are
+// thrown away when anything in them does not match what was asked for.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+#include "MappedFile.h"
+#include "VertexFormat.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+// Bump this whenever a generator or a vertex layout changes what it produces,
+// which invalidates every existing cache file
+const uint32_t MESH_CACHE_VERSION = 2;
+
+
+// What a mesh was generated from, e.g. { "icosphere", { radius, center.x, center.y, center.z, subdivisions } }
+struct MeshKey {
+	std::string generator;
+	std::vector<float> params;
+	VertexFormat format = VertexFormat::Float;
+
+	uint64_t hash() const;
+};
+
+
+// Mesh read back from a cache file, its data points into the mapping
+class CachedMesh {
+
+public:
+	CachedMesh(MappedFile file, size_t dataOffset, size_t vertexBytes, size_t indexCount, float boundingRadius);
+
+	// Public interface
+	const void* vertices() const { return file.data() + dataOffset; }
+	size_t vertexBytes() const { return verticesSize; }
+	const GLuint* indices() const { return reinterpret_cast<const GLuint*>(file.data() + dataOffset + verticesSize); }
+	size_t indexCount() const { return indicesCount; }
+	float boundingRadius() const { return radius; }
+
+private:
+	MappedFile file;
+	size_t dataOffset;
+	size_t verticesSize;
+	size_t indicesCount;
+	float radius;
+};
+
+
+class MeshCache {
+
+public:
+	// Cache files go in directory, which is created when the first one is written
+	MeshCache(std::string directory);
+
+	// The cached mesh for key, if there is a valid one
+	std::optional<CachedMesh> load(const MeshKey& key) const;
+
+	// Writes geom under key, replacing any old file. Failing to write is not
+	// an error, the mesh is just generated again next time.
+	// Safe to call from several threads for different keys.
+	void store(const MeshKey& key, const CPU_Geometry& geom) const;
+
+private:
+	std::string pathFor(const MeshKey& key) const;
+
+	std::string directory;
+};
@@ -0,0 +1,152 @@
+#include "MeshOptimizer.h"
+
+#include <type_traits>
+#include <utility>
+
+
+float acmr(const std::vector<GLuint>& indices, size_t vertexCount, int cacheSize) {
+	if (indices.size() < 3) {
+		return 0.0f;
+	}
+
+	// a vertex is still cached if fewer than cacheSize misses happened since its own
+	std::vector<size_t> missedAt(vertexCount, 0);
+	size_t misses = 0;
+	for (GLuint v : indices) {
+		if (missedAt[v] == 0 || misses - missedAt[v] >= size_t(cacheSize)) {
+			misses++;
+			missedAt[v] = misses;
+		}
+	}
+	return float(misses) / float(indices.size() / 3);
+}
+
+
+void optimizeVertexCache(CPU_Geometry& geom, int cacheSize) {
+	size_t vertexCount = geom.verts.size();
+	size_t triangleCount = geom.indices.size() / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// triangles using each vertex, packed one vertex after the other
+	std::vector<size_t> liveCount(vertexCount, 0);
+	for (GLuint v : geom.indices) {
+		liveCount[v]++;
+	}
+	std::vector<size_t> firstTriangle(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++) {
+		firstTriangle[v + 1] = firstTriangle[v] + liveCount[v];
+	}
+	std::vector<size_t> adjacency(geom.indices.size());
+	std::vector<size_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+	for (size_t i = 0; i < geom.indices.size(); i++) {
+		adjacency[filled[geom.indices[i]]++] = i / 3;
+	}
+
+	std::vector<GLuint> output;
+	output.reserve(geom.indices.size());
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<size_t> cacheTime(vertexCount, 0);
+	std::vector<GLuint> deadEnds;
+	size_t time = size_t(cacheSize) + 1;
+	size_t cursor = 0;
+
+	long long fanning = 0;
+	while (fanning >= 0) {
+		// emit every triangle left around the fanning vertex
+		std::vector<GLuint> candidates;
+		for (size_t a = firstTriangle[fanning]; a < firstTriangle[fanning + 1]; a++) {
+			size_t t = adjacency[a];
+			if (emitted[t]) {
+				continue;
+			}
+			for (size_t corner = 0; corner < 3; corner++) {
+				GLuint v = geom.indices[3 * t + corner];
+				output.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				liveCount[v]--;
+				if (time - cacheTime[v] > size_t(cacheSize)) {
+					cacheTime[v] = time;
+					time++;
+				}
+			}
+			emitted[t] = true;
+		}
+
+		// next fanning vertex: the candidate that will still be in the cache
+		// after its remaining triangles are emitted and has been in it longest
+		fanning = -1;
+		size_t best = 0;
+		for (GLuint v : candidates) {
+			if (liveCount[v] == 0) {
+				continue;
+			}
+			size_t priority = 0;
+			if (time - cacheTime[v] + 2 * liveCount[v] <= size_t(cacheSize)) {
+				priority = time - cacheTime[v];
+			}
+			if (fanning < 0 || priority > best) {
+				best = priority;
+				fanning = v;
+			}
+		}
+
+		// nothing useful nearby, go back to a recent vertex or on to the next one in order
+		while (fanning < 0 && !deadEnds.empty()) {
+			GLuint v = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveCount[v] > 0) {
+				fanning = v;
+			}
+		}
+		while (fanning < 0 && cursor < vertexCount) {
+			if (liveCount[cursor] > 0) {
+				fanning = (long long)cursor;
+			}
+			cursor++;
+		}
+	}
+
+	geom.indices.swap(output);
+}
+
+
+void optimizeVertexFetch(CPU_Geometry& geom) {
+	const GLuint UNUSED = GLuint(-1);
+	std::vector<GLuint> remap(geom.verts.size(), UNUSED);
+	GLuint next = 0;
+	for (GLuint& v : geom.indices) {
+		if (remap[v] == UNUSED) {
+			remap[v] = next++;
+		}
+		v = remap[v];
+	}
+
+	auto reorder = [&](auto& attribute) {
+		if (attribute.size() != remap.size()) {
+			return; // attribute not used by this mesh
+		}
+		std::remove_reference_t<decltype(attribute)> reordered(next);
+		for (size_t i = 0; i < remap.size(); i++) {
+			if (remap[i] != UNUSED) {
+				reordered[remap[i]] = attribute[i];
+			}
+		}
+		attribute.swap(reordered);
+	};
+	reorder(geom.verts);
+	reorder(geom.cols);
+	reorder(geom.normals);
+}
+
+
+MeshOptimizationReport optimizeMesh(CPU_Geometry& geom) {
+	MeshOptimizationReport report;
+	report.acmrBefore = acmr(geom.indices, geom.verts.size());
+	optimizeVertexCache(geom);
+	optimizeVertexFetch(geom);
+	report.acmrAfter = acmr(geom.indices, geom.verts.size());
+	return report;
+}
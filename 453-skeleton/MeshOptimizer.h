@@ -0,0 +1,37 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Reordering passes for indexed triangle meshes, run after a mesh is generated
+// and before it is uploaded. Neither changes what is drawn, only the order:
+// triangles so the GPU's post-transform cache reuses more shaded vertices, then
+// vertices so the vertex shader reads its input front to back.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+
+#include <vector>
+
+
+// Post-transform cache size assumed by the passes and by acmr()
+const int VERTEX_CACHE_SIZE = 16;
+
+// Average cache miss ratio: vertex shader invocations per triangle with a FIFO
+// cache of cacheSize vertices. 0.5 is the best a large regular mesh can do, 3
+// means no vertex is ever reused.
+float acmr(const std::vector<GLuint>& indices, size_t vertexCount, int cacheSize = VERTEX_CACHE_SIZE);
+
+// Reorders the triangles of geom with Tipsify (Sander, Nehab and Barczak 2007)
+void optimizeVertexCache(CPU_Geometry& geom, int cacheSize = VERTEX_CACHE_SIZE);
+
+// Renumbers the vertices of geom in the order the indices first use them,
+// dropping any that no triangle uses
+void optimizeVertexFetch(CPU_Geometry& geom);
+
+
+struct MeshOptimizationReport {
+	float acmrBefore = 0.0f;
+	float acmrAfter = 0.0f;
+};
+
+// Both passes, in the order they have to run
+MeshOptimizationReport optimizeMesh(CPU_Geometry& geom);
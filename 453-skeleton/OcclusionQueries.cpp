@@ -0,0 +1,101 @@
+#include "OcclusionQueries.h"
+
+#include <cmath>
+#include <utility>
+
+
+OcclusionQueries::OcclusionQueries(float nearPlane)
+	: proxyProgram("shaders/proxy.vert", "shaders/proxy.frag")
+	, vao()
+	, nearPlane(nearPlane)
+{}
+
+
+void OcclusionQueries::collect() {
+	for (BodyQuery& query : bodies) {
+		query.current = -1;
+		// oldest first, so the newest result that came back wins
+		for (size_t i = 0; i < STREAM_FRAMES_IN_FLIGHT; i++) {
+			size_t slot = (query.next + i) % STREAM_FRAMES_IN_FLIGHT;
+			if (!query.pending[slot]) {
+				continue;
+			}
+			GLuint available = GL_FALSE;
+			glGetQueryObjectuiv(query.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available == GL_FALSE) {
+				break; // the newer ones aren't back either, try again next frame
+			}
+			GLuint samples = 0;
+			glGetQueryObjectuiv(query.queries[slot], GL_QUERY_RESULT, &samples);
+			query.pending[slot] = false;
+			query.visible = samples > 0;
+			if (!query.visible) {
+				stats.hidden++;
+			}
+		}
+	}
+}
+
+
+bool OcclusionQueries::wasVisible(size_t id) const {
+	return id >= bodies.size() || bodies[id].visible;
+}
+
+
+void OcclusionQueries::query(size_t id, BoundingSphere const& sphere, glm::vec3 eye) {
+	BodyQuery& query = body(id);
+
+	// from inside the box, or close enough for the near plane to cut into it,
+	// the proxy can't say anything
+	glm::vec3 offset = eye - sphere.center;
+	float reach = sphere.radius + nearPlane;
+	if (std::abs(offset.x) <= reach && std::abs(offset.y) <= reach && std::abs(offset.z) <= reach) {
+		query.pending.fill(false); // older results would be stale by the time they come back
+		query.visible = true;
+		return;
+	}
+
+	// every slot still waiting means the GPU is more frames behind than there are
+	// slots, skip this frame rather than throw away a result that is nearly back
+	size_t slot = query.next;
+	if (query.pending[slot]) {
+		return;
+	}
+
+	proxyProgram.setUniform("center", sphere.center);
+	proxyProgram.setUniform("radius", sphere.radius);
+	glBeginQuery(GL_ANY_SAMPLES_PASSED, query.queries[slot]);
+	glDrawArrays(GL_TRIANGLES, 0, 36);
+	glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+	query.pending[slot] = true;
+	query.current = int(slot);
+	query.next = (slot + 1) % STREAM_FRAMES_IN_FLIGHT;
+	stats.queried++;
+}
+
+
+void OcclusionQueries::drawConditional(size_t id, std::function<void()> const& draw) {
+	if (id >= bodies.size() || bodies[id].current < 0) {
+		draw();
+		return;
+	}
+	// the GPU waits for the query, the CPU never does
+	glBeginConditionalRender(bodies[id].queries[bodies[id].current], GL_QUERY_WAIT);
+	draw();
+	glEndConditionalRender();
+	stats.conditional++;
+}
+
+
+OcclusionQueries::Stats OcclusionQueries::takeStats() {
+	return std::exchange(stats, Stats{});
+}
+
+
+OcclusionQueries::BodyQuery& OcclusionQueries::body(size_t id) {
+	if (id >= bodies.size()) {
+		bodies.resize(id + 1);
+	}
+	return bodies[id];
+}
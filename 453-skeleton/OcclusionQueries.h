@@ -0,0 +1,99 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Hardware occlusion queries for skipping bodies hidden behind other bodies.
+//
+// Every frame each body gets a query around a cheap proxy, a box around its
+// bounding sphere, drawn after everything opaque with colour and depth writes
+// off. The results are only read once the GPU says they are available, so
+// asking never waits; a body's last finished result says whether it is drawn
+// normally next frame. Bodies whose last result was zero samples are drawn on
+// their own inside glBeginConditionalRender instead, on this frame's query, so
+// the GPU skips them while they stay hidden and they show up as soon as they
+// don't, with no frame of lag.
+//------------------------------------------------------------------------------
+
+#include "Frustum.h"
+#include "GLHandles.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include "VertexArray.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+
+class OcclusionQueries {
+
+public:
+	// Counts for one frame
+	struct Stats {
+		size_t queried = 0;     // proxies drawn
+		size_t hidden = 0;      // results that came back with no samples
+		size_t conditional = 0; // draws left for the GPU to skip
+
+		bool operator==(Stats const& other) const {
+			return queried == other.queried && hidden == other.hidden && conditional == other.conditional;
+		}
+		bool operator!=(Stats const& other) const { return !(*this == other); }
+	};
+
+	// Proxies within nearPlane of the eye are never queried, the near plane could clip them away
+	OcclusionQueries(float nearPlane);
+
+	// Because we're using the QueryHandle to do RAII for the queries for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	// Reads every result that has come back and starts a new frame. Never waits.
+	void collect();
+
+	// What the last result for body id said, true until there is one
+	bool wasVisible(size_t id) const;
+
+	// What the proxies are drawn with, no vertex attributes
+	ShaderProgram& program() { return proxyProgram; }
+	const VertexArray& vertexArray() const { return vao; }
+
+	// Draws the proxy of body id around sphere. The proxy program and VAO have
+	// to be bound and colour and depth writes should be off.
+	void query(size_t id, BoundingSphere const& sphere, glm::vec3 eye);
+
+	// Makes draw only happen on the GPU if this frame's query of body id passed any
+	// samples. Draws unconditionally if it wasn't queried.
+	void drawConditional(size_t id, std::function<void()> const& draw);
+
+	// The counts since the last time this was called, call once per frame
+	Stats takeStats();
+
+private:
+	// One query per frame in flight, like StreamBuffer's regions, so a GPU a few
+	// frames behind still gets to finish a query before it is issued again
+	struct BodyQuery {
+		std::array<QueryHandle, STREAM_FRAMES_IN_FLIGHT> queries;
+		std::array<bool, STREAM_FRAMES_IN_FLIGHT> pending{}; // issued and not read back yet
+		size_t next = 0;      // slot of the next query, also the oldest one issued
+		int current = -1;     // slot of this frame's query, -1 if there is none
+		bool visible = true;  // last result read
+	};
+
+
+	BodyQuery& body(size_t id);
+
+	ShaderProgram proxyProgram;
+	VertexArray vao;
+	float nearPlane;
+	std::vector<BodyQuery> bodies; // by id
+	Stats stats;
+};
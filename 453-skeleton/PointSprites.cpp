@@ -0,0 +1,16 @@
+#include "PointSprites.h"
+
+
+GPU_PointSprites::GPU_PointSprites()
+	: vao()
+	, stream(64 * Layout::stride)
+{}
+
+
+void GPU_PointSprites::upload(const CPU_PointSprites& sprites) {
+	std::vector<unsigned char> vertices = Layout::interleave(sprites);
+	size_t offset = stream.write(vertices.data(), vertices.size(), sizeof(float));
+	vao.bind();
+	stream.bind(GL_ARRAY_BUFFER);
+	Layout::setAttribPointers(offset);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Bodies that cover less than a pixel or so are not worth a mesh. These
+// classes store them as points, one flat coloured round sprite per body, so
+// all of them can be drawn together with a single GL_POINTS call.
+//------------------------------------------------------------------------------
+
+#include "StreamBuffer.h"
+#include "VertexArray.h"
+#include "VertexLayout.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// One entry per body: world position, colour and diameter in pixels
+struct CPU_PointSprites {
+	std::vector<glm::vec3> verts;
+	std::vector<glm::vec3> colors;
+	std::vector<float> sizes;
+
+	void clear() {
+		verts.clear();
+		colors.clear();
+		sizes.clear();
+	}
+};
+
+
+// Attribute descriptors for VertexLayout, see VertexLayout.h
+struct SpriteColor3f {
+	using value_type = glm::vec3;
+	static constexpr GLuint locations[] = { 1 };
+	static constexpr GLint components = 3;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+
+	template <typename Geometry>
+	static value_type fetch(const Geometry& geom, size_t i) { return geom.colors[i]; }
+};
+
+struct SpriteSize1f {
+	using value_type = float;
+	static constexpr GLuint locations[] = { 2 };
+	static constexpr GLint components = 1;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+
+	template <typename Geometry>
+	static value_type fetch(const Geometry& geom, size_t i) { return geom.sizes[i]; }
+};
+
+
+// VAO and one interleaved stream buffer, rewritten every frame
+class GPU_PointSprites {
+
+public:
+	using Layout = VertexLayout<Position3f, SpriteColor3f, SpriteSize1f>;
+
+	GPU_PointSprites();
+
+	// Public interface
+	void bind() { vao.bind(); }
+	const VertexArray& vertexArray() const { return vao; }
+
+	// Also points the VAO at where the sprites went, so draw from vertex 0 after it
+	void upload(const CPU_PointSprites& sprites);
+
+private:
+	// note: due to how OpenGL works, vao needs to be
+	// defined and initialized before the vertex buffers
+	VertexArray vao;
+
+	StreamBuffer stream;
+};
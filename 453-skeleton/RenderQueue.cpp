@@ -0,0 +1,63 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <utility>
+
+
+bool RenderQueue::Stats::operator==(const Stats& other) const {
+	return draws == other.draws && shaderBinds == other.shaderBinds
+		&& textureBinds == other.textureBinds && vertexArrayBinds == other.vertexArrayBinds;
+}
+
+
+uint64_t RenderQueue::makeKey(RenderPass pass, GLuint shader, GLuint texture, float depth) {
+	uint64_t quantizedDepth = uint64_t(std::clamp(depth, 0.0f, 1.0f) * double(0xFFFFFFFFu));
+	return (uint64_t(pass) & 0xF) << 60
+		| (uint64_t(shader) & 0xFF) << 52
+		| (uint64_t(texture) & 0xFFFF) << 36
+		| quantizedDepth;
+}
+
+
+void RenderQueue::submit(RenderCommand command) {
+	commands.push_back(std::move(command));
+}
+
+
+RenderQueue::Stats RenderQueue::flush() {
+	// stable, so draws with equal keys keep the order they came in
+	std::stable_sort(commands.begin(), commands.end(), [](RenderCommand const& a, RenderCommand const& b) {
+		return a.key < b.key;
+	});
+
+	Stats stats;
+	const ShaderProgram* shader = nullptr;
+	const Texture* texture = nullptr;
+	const VertexArray* vertexArray = nullptr;
+
+	for (RenderCommand& command : commands) {
+		if (command.shader != shader) {
+			shader = command.shader;
+			shader->use();
+			stats.shaderBinds++;
+		}
+		if (command.texture != nullptr && command.texture != texture) {
+			texture = command.texture;
+			command.texture->bind();
+			stats.textureBinds++;
+		}
+		if (command.vertexArray == nullptr) {
+			vertexArray = nullptr; // whatever the draw binds is unknown here
+		}
+		else if (command.vertexArray != vertexArray) {
+			vertexArray = command.vertexArray;
+			vertexArray->bind();
+			stats.vertexArrayBinds++;
+		}
+		command.draw();
+		stats.draws++;
+	}
+
+	commands.clear();
+	return stats;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Draws are submitted here during the frame and made all at once by flush(),
+// sorted by a 64-bit key. From the highest bits down the key holds the pass,
+// the shader program, the texture and the depth, so draws sharing a program
+// and texture end up next to each other and the queue only binds state when it
+// differs from the draw before. The number of binds then grows with the
+// number of distinct materials instead of the number of bodies.
+//------------------------------------------------------------------------------
+
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "VertexArray.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+// Every draw of a pass is made before any draw of the next one
+enum class RenderPass : uint64_t {
+	Opaque = 0,      // bodies, rings and sprites
+	Occlusion = 1,   // proxies of the bodies, tested against the depth of everything opaque
+	Conditional = 2, // bodies only drawn if their proxy passed, see OcclusionQueries
+	Sky = 3,         // after the bodies, so the depth test throws out what they cover
+	Overlay = 4,     // debug lines
+};
+
+
+// A draw and the state it needs bound first
+struct RenderCommand {
+	uint64_t key;
+	const ShaderProgram* shader;
+	Texture* texture;               // nullptr to leave the bound texture alone
+	const VertexArray* vertexArray; // nullptr if draw binds its own
+	std::function<void()> draw;     // sets the rest of its state and makes the draw call
+};
+
+
+class RenderQueue {
+
+public:
+	// How often each kind of state was bound by a flush
+	struct Stats {
+		size_t draws = 0;
+		size_t shaderBinds = 0;
+		size_t textureBinds = 0;
+		size_t vertexArrayBinds = 0;
+
+		bool operator==(const Stats& other) const;
+		bool operator!=(const Stats& other) const { return !(*this == other); }
+	};
+
+	// Pass in bits 60 to 63, the low 8 bits of the program name in 52 to 59,
+	// the low 16 bits of the texture name in 36 to 51 and depth in the low 32.
+	// depth goes from 0 at the camera to 1 at the far plane, so each material
+	// is drawn front to back.
+	static uint64_t makeKey(RenderPass pass, GLuint shader, GLuint texture, float depth);
+
+	void submit(RenderCommand command);
+
+	// Sorts and makes every draw submitted since the last flush
+	Stats flush();
+
+private:
+	std::vector<RenderCommand> commands;
+};
@@ -1,32 +1,73 @@
 #include "ShaderProgram.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
+#include <glm/gtc/type_ptr.hpp>
+
 #include "Log.h"
+#include "UniformBuffer.h"
 
 
 ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath)
 	: programID()
 	, vertex(vertexPath, GL_VERTEX_SHADER)
-	, fragment(fragmentPath, GL_FRAGMENT_SHADER)
+	, geometry()
+	, fragment(std::in_place, fragmentPath, GL_FRAGMENT_SHADER)
+	, feedbackVaryings()
+{
+	link();
+}
+
+
+ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& geometryPath,
+		const std::vector<std::string>& feedbackVaryings)
+	: programID()
+	, vertex(vertexPath, GL_VERTEX_SHADER)
+	, geometry(std::in_place, geometryPath, GL_GEOMETRY_SHADER)
+	, fragment()
+	, feedbackVaryings(feedbackVaryings)
 {
+	link();
+}
+
+
+void ShaderProgram::link() {
 	attach(*this, vertex);
-	attach(*this, fragment);
+	if (geometry) {
+		attach(*this, *geometry);
+	}
+	if (fragment) {
+		attach(*this, *fragment);
+	}
+
+	// has to be set before linking
+	if (!feedbackVaryings.empty()) {
+		std::vector<const GLchar*> names;
+		for (const std::string& varying : feedbackVaryings) {
+			names.push_back(varying.c_str());
+		}
+		glTransformFeedbackVaryings(programID, GLsizei(names.size()), names.data(), GL_INTERLEAVED_ATTRIBS);
+	}
 	glLinkProgram(programID);
 
 	if (!checkAndLogLinkSuccess()) {
 		glDeleteProgram(programID);
 		throw std::runtime_error("Shaders did not link.");
 	}
+	reflectUniforms();
 }
 
 bool ShaderProgram::recompile() {
 
 	try {
-		// Try to create a new program
-		ShaderProgram newProgram(vertex.getPath(), fragment.getPath());
+		// Try to create a new program, moving it in also brings its uniform table
+		ShaderProgram newProgram = fragment
+			? ShaderProgram(vertex.getPath(), fragment->getPath())
+			: ShaderProgram(vertex.getPath(), geometry->getPath(), feedbackVaryings);
 		*this = std::move(newProgram);
 		return true;
 	}
@@ -53,11 +94,122 @@ bool ShaderProgram::checkAndLogLinkSuccess() const {
 		std::vector<char> log(logLength);
 		glGetProgramInfoLog(programID, logLength, NULL, log.data());
 
-		Log::error("SHADER_PROGRAM linking {} + {}:\n{}", vertex.getPath(), fragment.getPath(), log.data());
+		Log::error("SHADER_PROGRAM linking {}:\n{}", describe(), log.data());
 		return false;
 	}
 	else {
-		Log::info("SHADER_PROGRAM successfully compiled and linked {} + {}", vertex.getPath(), fragment.getPath());
+		Log::info("SHADER_PROGRAM successfully compiled and linked {}", describe());
 		return true;
 	}
 }
+
+
+std::string ShaderProgram::describe() const {
+	std::string paths = vertex.getPath();
+	if (geometry) {
+		paths += " + " + geometry->getPath();
+	}
+	if (fragment) {
+		paths += " + " + fragment->getPath();
+	}
+	return paths;
+}
+
+
+GLint ShaderProgram::uniformLocation(const std::string& name) const {
+	auto found = uniforms.find(name);
+	return found != uniforms.end() ? found->second.location : -1;
+}
+
+
+void ShaderProgram::setUniform(const std::string& name, float value) const {
+	if (const UniformInfo* uniform = findUniform(name, GL_FLOAT)) {
+		glUniform1f(uniform->location, value);
+	}
+}
+
+void ShaderProgram::setUniform(const std::string& name, int value) const {
+	if (const UniformInfo* uniform = findUniform(name, GL_INT)) {
+		glUniform1i(uniform->location, value);
+	}
+}
+
+void ShaderProgram::setUniform(const std::string& name, const glm::vec3& value) const {
+	if (const UniformInfo* uniform = findUniform(name, GL_FLOAT_VEC3)) {
+		glUniform3fv(uniform->location, 1, glm::value_ptr(value));
+	}
+}
+
+void ShaderProgram::setUniform(const std::string& name, const glm::mat3& value) const {
+	if (const UniformInfo* uniform = findUniform(name, GL_FLOAT_MAT3)) {
+		glUniformMatrix3fv(uniform->location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
+void ShaderProgram::setUniform(const std::string& name, const glm::mat4& value) const {
+	if (const UniformInfo* uniform = findUniform(name, GL_FLOAT_MAT4)) {
+		glUniformMatrix4fv(uniform->location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
+
+void ShaderProgram::reflectUniforms() {
+	uniforms.clear();
+
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<char> name(std::max(maxLength, 1));
+
+	for (GLint i = 0; i < count; i++) {
+		GLsizei length = 0;
+		UniformInfo uniform{ -1, GL_NONE, 0 };
+		glGetActiveUniform(programID, GLuint(i), GLsizei(name.size()), &length, &uniform.size, &uniform.type, name.data());
+
+		// members of uniform blocks are active but have no location
+		uniform.location = glGetUniformLocation(programID, name.data());
+		if (uniform.location < 0) {
+			continue;
+		}
+
+		std::string uniformName(name.data(), length);
+		if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0) {
+			uniformName.resize(uniformName.size() - 3);
+		}
+		uniforms[uniformName] = uniform;
+	}
+
+	// shared uniform blocks go to their fixed binding points
+	GLint blockCount = 0;
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+	for (GLint i = 0; i < blockCount; i++) {
+		GLint nameLength = 0;
+		glGetActiveUniformBlockiv(programID, GLuint(i), GL_UNIFORM_BLOCK_NAME_LENGTH, &nameLength);
+		std::vector<char> blockName(std::max(nameLength, 1));
+		glGetActiveUniformBlockName(programID, GLuint(i), GLsizei(blockName.size()), nullptr, blockName.data());
+
+		GLint binding = uniformBlockBinding(blockName.data());
+		if (binding < 0) {
+			Log::warn("SHADER_PROGRAM {}: no binding point for uniform block {}", describe(), blockName.data());
+			continue;
+		}
+		glUniformBlockBinding(programID, GLuint(i), GLuint(binding));
+	}
+}
+
+const UniformInfo* ShaderProgram::findUniform(const std::string& name, GLenum type) const {
+	auto found = uniforms.find(name);
+	if (found == uniforms.end()) {
+		return nullptr;
+	}
+
+	const UniformInfo& uniform = found->second;
+	bool integer = uniform.type == GL_INT || uniform.type == GL_BOOL
+		|| uniform.type == GL_SAMPLER_2D || uniform.type == GL_SAMPLER_2D_ARRAY || uniform.type == GL_SAMPLER_BUFFER;
+	if (uniform.type != type && !(type == GL_INT && integer)) {
+		Log::warn("SHADER_PROGRAM {}: uniform {} has type {:#x}, not {:#x}", describe(), name, uniform.type, type);
+		return nullptr;
+	}
+	return &uniform;
+}
@@ -3,18 +3,37 @@
 #include "Shader.h"
 
 #include "GLHandles.h"
+#include "GLState.h"
 
 //#include <GL/glew.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <glm/glm.hpp>
+
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// An active uniform of a linked program, as glGetActiveUniform reports it
+struct UniformInfo {
+	GLint location;
+	GLenum type; // GL_FLOAT_VEC3, GL_FLOAT_MAT4, GL_SAMPLER_2D, ...
+	GLint size;  // number of elements for arrays, 1 otherwise
+};
 
 
 class ShaderProgram {
 
 public:
 	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
+	// Vertex and geometry shaders with no fragment shader, for passes that only
+	// write to transform feedback. The geometry shader outputs named in
+	// feedbackVaryings are captured interleaved, in that order.
+	ShaderProgram(const std::string& vertexPath, const std::string& geometryPath,
+		const std::vector<std::string>& feedbackVaryings);
 
 	// Because we're using the ShaderProgramHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
@@ -25,7 +44,25 @@ public:
 
 	// Public interface
 	bool recompile();
-	void use() const { glUseProgram(programID); }
+	void use() const { GLState::useProgram(programID); }
+
+
+	// Uniforms the linker kept, looked up once per link so drawing never asks
+	// the driver for a location. Uniforms the shaders don't read are optimized
+	// out and have no entry, so check hasUniform before computing a value that
+	// only such a uniform would use. Arrays are listed without the "[0]".
+	// Uniform blocks are bound to their binding points from UniformBuffer.h.
+	bool hasUniform(const std::string& name) const { return uniforms.count(name) != 0; }
+	GLint uniformLocation(const std::string& name) const;
+	const std::unordered_map<std::string, UniformInfo>& activeUniforms() const { return uniforms; }
+
+	// Set a uniform of this program, which has to be in use. Does nothing if the
+	// uniform is inactive, and warns if it is declared with a different type.
+	void setUniform(const std::string& name, float value) const;
+	void setUniform(const std::string& name, int value) const; // also bools and samplers
+	void setUniform(const std::string& name, const glm::vec3& value) const;
+	void setUniform(const std::string& name, const glm::mat3& value) const;
+	void setUniform(const std::string& name, const glm::mat4& value) const;
 
 	void friend attach(ShaderProgram& sp, Shader& s);
 
@@ -37,7 +74,17 @@ private:
 	ShaderProgramHandle programID;
 
 	Shader vertex;
-	Shader fragment;
+	std::optional<Shader> geometry;
+	std::optional<Shader> fragment;
+	std::vector<std::string> feedbackVaryings;
+
+	std::unordered_map<std::string, UniformInfo> uniforms;
 
+	void link(); // throws if it fails
 	bool checkAndLogLinkSuccess() const;
+	std::string describe() const; // the shader paths, for the log
+
+	void reflectUniforms(); // and binds the uniform blocks
+
+	const UniformInfo* findUniform(const std::string& name, GLenum type) const;
 };
@@ -0,0 +1,348 @@
+#include "SphereGeometry.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <utility>
+
+
+namespace {
+
+	const float EPSILON = 1e-5f;
+
+	// Equirectangular texture coordinates, u grows with the rotation about +y
+	// starting at +x and v is 0 at the top, like the old latitude/longitude lattice
+
+	float longitudeU(glm::vec3 p) {
+		float theta = std::atan2(-p.z, p.x);
+		if (theta < 0.0f) {
+			theta += glm::two_pi<float>();
+		}
+		return theta / glm::two_pi<float>();
+	}
+
+	float latitudeV(glm::vec3 p) {
+		return std::acos(glm::clamp(p.y, -1.0f, 1.0f)) / glm::pi<float>();
+	}
+
+	// Adds a triangle of unit sphere points facing outwards
+	void addTriangle(std::vector<GLuint>& triangles, std::vector<glm::vec3> const& points, GLuint a, GLuint b, GLuint c) {
+		glm::vec3 normal = glm::cross(points[b] - points[a], points[c] - points[a]);
+		if (glm::dot(normal, points[a] + points[b] + points[c]) < 0.0f) {
+			std::swap(b, c);
+		}
+		triangles.push_back(a);
+		triangles.push_back(b);
+		triangles.push_back(c);
+	}
+
+
+	// Turns a closed mesh of unit sphere points into textured geometry.
+	//
+	// u jumps from 1 back to 0 on the half plane z = 0, x > 0, and is undefined
+	// on the poles, so vertices there can't be shared by every triangle using
+	// them. Triangles touching the seam get a copy of the seam vertex with u = 0
+	// or u = 1 depending on their side, triangles crossing it are cut in two
+	// along it, and every triangle on a pole gets its own pole vertex with the
+	// u of its other corners. All texture coordinates stay within [0, 1].
+	class SphereUnwrapper {
+
+	public:
+		SphereUnwrapper(std::vector<glm::vec3> const& points, float radius, glm::vec3 center) :
+			points(points),
+			radius(radius),
+			center(center),
+			regular(points.size(), UNUSED)
+		{
+			geom.verts.reserve(points.size());
+			geom.cols.reserve(points.size());
+			geom.normals.reserve(points.size());
+		}
+
+		void addTriangle(GLuint a, GLuint b, GLuint c) {
+			std::array<GLuint, 3> triangle = { a, b, c };
+
+			// corners in order, with the points where an edge crosses the seam
+			std::vector<Corner> loop;
+			for (int i = 0; i < 3; i++) {
+				loop.push_back(corner(triangle[i]));
+				cutCorner(triangle[i], triangle[(i + 1) % 3], loop);
+			}
+
+			// split into the parts on each side of the seam
+			std::vector<size_t> splits;
+			for (size_t i = 0; i < loop.size(); i++) {
+				if (loop[i].kind != Kind::Regular) {
+					splits.push_back(i);
+				}
+			}
+			if (splits.size() != 2) {
+				addPolygon(loop);
+				return;
+			}
+			addPolygon(std::vector<Corner>(loop.begin() + splits[0], loop.begin() + splits[1] + 1));
+			std::vector<Corner> rest(loop.begin() + splits[1], loop.end());
+			rest.insert(rest.end(), loop.begin(), loop.begin() + splits[0] + 1);
+			addPolygon(rest);
+		}
+
+		CPU_Geometry& geometry() { return geom; }
+
+	private:
+		static constexpr GLuint UNUSED = GLuint(-1);
+
+		enum class Kind { Regular, Seam, Pole };
+
+		struct Corner {
+			Kind kind;
+			GLuint key; // point index, or points.size() + cut index for points on cut edges
+			glm::vec3 p;
+		};
+
+		Corner corner(GLuint i) {
+			glm::vec3 p = points[i];
+			if (p.x * p.x + p.z * p.z < EPSILON * EPSILON) {
+				return { Kind::Pole, i, p };
+			}
+			if (std::abs(p.z) < EPSILON && p.x > 0.0f) {
+				return { Kind::Seam, i, p };
+			}
+			return { Kind::Regular, i, p };
+		}
+
+		// Adds the point where the edge a -> b crosses the seam to loop, if it does
+		void cutCorner(GLuint a, GLuint b, std::vector<Corner>& loop) {
+			glm::vec3 pa = points[a];
+			glm::vec3 pb = points[b];
+			if (std::abs(pa.z) < EPSILON || std::abs(pb.z) < EPSILON || (pa.z < 0.0f) == (pb.z < 0.0f)) {
+				return;
+			}
+			float t = pa.z / (pa.z - pb.z);
+			glm::vec3 p = glm::mix(pa, pb, t);
+			if (p.x <= 0.0f) {
+				return; // crosses u = 0.5 on the far side, nothing to do there
+			}
+			p.z = 0.0f;
+			p = glm::normalize(p);
+
+			// the triangle on the other side of the edge has to cut it at the same vertex
+			std::pair<GLuint, GLuint> edge = std::minmax(a, b);
+			auto found = cuts.find(edge);
+			GLuint key;
+			if (found != cuts.end()) {
+				key = found->second;
+			}
+			else {
+				key = GLuint(points.size() + cuts.size());
+				cuts[edge] = key;
+			}
+			loop.push_back({ Kind::Seam, key, p });
+		}
+
+		// Fans a convex polygon that lies on one side of the seam
+		void addPolygon(std::vector<Corner> const& corners) {
+			if (corners.size() < 3) {
+				return;
+			}
+
+			// which side the polygon is on, seam corners take u from it
+			bool high = false;
+			for (Corner const& c : corners) {
+				if (c.kind == Kind::Regular) {
+					high = longitudeU(c.p) > 0.5f;
+					break;
+				}
+			}
+
+			float uSum = 0.0f;
+			int uCount = 0;
+			for (Corner const& c : corners) {
+				if (c.kind == Kind::Regular) {
+					uSum += longitudeU(c.p);
+					uCount++;
+				}
+				else if (c.kind == Kind::Seam) {
+					uSum += high ? 1.0f : 0.0f;
+					uCount++;
+				}
+			}
+			float poleU = uCount > 0 ? uSum / float(uCount) : 0.5f;
+
+			std::vector<GLuint> indices;
+			for (Corner const& c : corners) {
+				indices.push_back(vertex(c, high, poleU));
+			}
+			for (size_t i = 1; i + 1 < indices.size(); i++) {
+				geom.indices.push_back(indices[0]);
+				geom.indices.push_back(indices[i]);
+				geom.indices.push_back(indices[i + 1]);
+			}
+		}
+
+		GLuint vertex(Corner const& c, bool high, float poleU) {
+			switch (c.kind) {
+			case Kind::Regular:
+				if (regular[c.key] == UNUSED) {
+					regular[c.key] = addVertex(c.p, glm::vec2(longitudeU(c.p), latitudeV(c.p)));
+				}
+				return regular[c.key];
+			case Kind::Seam: {
+				auto found = seamCopies.find({ c.key, high });
+				if (found != seamCopies.end()) {
+					return found->second;
+				}
+				GLuint index = addVertex(c.p, glm::vec2(high ? 1.0f : 0.0f, latitudeV(c.p)));
+				seamCopies[{ c.key, high }] = index;
+				return index;
+			}
+			default:
+				return addVertex(c.p, glm::vec2(poleU, latitudeV(c.p)));
+			}
+		}
+
+		GLuint addVertex(glm::vec3 p, glm::vec2 uv) {
+			geom.verts.push_back(center + radius * p);
+			geom.cols.push_back(uv);
+			geom.normals.push_back(p);
+			return GLuint(geom.verts.size() - 1);
+		}
+
+		std::vector<glm::vec3> const& points;
+		float radius;
+		glm::vec3 center;
+
+		CPU_Geometry geom;
+		std::vector<GLuint> regular;
+		std::map<std::pair<GLuint, GLuint>, GLuint> cuts;
+		std::map<std::pair<GLuint, bool>, GLuint> seamCopies;
+	};
+
+	CPU_Geometry unwrapSphere(std::vector<glm::vec3> const& points, std::vector<GLuint> const& triangles, float radius, glm::vec3 center) {
+		SphereUnwrapper unwrapper(points, radius, center);
+		unwrapper.geometry().indices.reserve(triangles.size() + triangles.size() / 8);
+		for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+			unwrapper.addTriangle(triangles[i], triangles[i + 1], triangles[i + 2]);
+		}
+		return std::move(unwrapper.geometry());
+	}
+
+}
+
+
+CPU_Geometry icosphereGeometry(float radius, glm::vec3 center, int subdivisions) {
+	std::vector<glm::vec3> points;
+	std::vector<GLuint> triangles;
+	// every subdivision turns each triangle into four and adds a point per edge
+	size_t faces = size_t(20) << (2 * subdivisions);
+	points.reserve(faces / 2 + 2);
+	triangles.reserve(3 * faces);
+
+	// icosahedron standing on a vertex, so the poles are vertices and the
+	// edges from the top pole run along the seam instead of across it
+	float y = 1.0f / std::sqrt(5.0f);
+	float r = 2.0f / std::sqrt(5.0f);
+	points.push_back(glm::vec3{ 0.0f, 1.0f, 0.0f });
+	points.push_back(glm::vec3{ 0.0f, -1.0f, 0.0f });
+	for (int i = 0; i < 5; i++) {
+		float upper = glm::radians(72.0f * i);
+		float lower = glm::radians(72.0f * i + 36.0f);
+		points.push_back(glm::vec3{ r * std::cos(upper), y, -r * std::sin(upper) });
+		points.push_back(glm::vec3{ r * std::cos(lower), -y, -r * std::sin(lower) });
+	}
+	for (GLuint i = 0; i < 5; i++) {
+		GLuint upper = 2 + 2 * i;
+		GLuint lower = upper + 1;
+		GLuint nextUpper = 2 + 2 * ((i + 1) % 5);
+		GLuint nextLower = nextUpper + 1;
+		addTriangle(triangles, points, 0, upper, nextUpper);
+		addTriangle(triangles, points, upper, lower, nextUpper);
+		addTriangle(triangles, points, lower, nextLower, nextUpper);
+		addTriangle(triangles, points, 1, nextLower, lower);
+	}
+
+	for (int s = 0; s < subdivisions; s++) {
+		std::vector<GLuint> finer;
+		finer.reserve(3 * faces);
+		std::map<std::pair<GLuint, GLuint>, GLuint> midpoints;
+		auto midpoint = [&](GLuint a, GLuint b) {
+			std::pair<GLuint, GLuint> edge = std::minmax(a, b);
+			auto found = midpoints.find(edge);
+			if (found != midpoints.end()) {
+				return found->second;
+			}
+			points.push_back(glm::normalize(points[a] + points[b]));
+			GLuint index = GLuint(points.size() - 1);
+			midpoints[edge] = index;
+			return index;
+		};
+
+		for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+			GLuint a = triangles[i];
+			GLuint b = triangles[i + 1];
+			GLuint c = triangles[i + 2];
+			GLuint ab = midpoint(a, b);
+			GLuint bc = midpoint(b, c);
+			GLuint ca = midpoint(c, a);
+			finer.insert(finer.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+		}
+		triangles.swap(finer);
+	}
+
+	return unwrapSphere(points, triangles, radius, center);
+}
+
+
+CPU_Geometry cubeSphereGeometry(float radius, glm::vec3 center, int subdivisions) {
+	int n = subdivisions;
+	std::vector<glm::vec3> points;
+	std::vector<GLuint> triangles;
+	points.reserve(6 * n * n + 2);
+	triangles.reserve(6 * 6 * n * n);
+
+	// grid points on the surface of the cube [0, n]^3, shared between faces
+	std::map<std::array<int, 3>, GLuint> grid;
+	auto gridPoint = [&](std::array<int, 3> const& c) {
+		auto found = grid.find(c);
+		if (found != grid.end()) {
+			return found->second;
+		}
+		// tan spreads the points so they are evenly spaced in angle instead of
+		// bunching up towards the middle of each face once projected
+		glm::vec3 p;
+		for (int k = 0; k < 3; k++) {
+			p[k] = std::tan((2.0f * float(c[k]) / float(n) - 1.0f) * glm::quarter_pi<float>());
+		}
+		points.push_back(glm::normalize(p));
+		GLuint index = GLuint(points.size() - 1);
+		grid[c] = index;
+		return index;
+	};
+
+	for (int axis = 0; axis < 3; axis++) {
+		int a1 = (axis + 1) % 3;
+		int a2 = (axis + 2) % 3;
+		for (int side : { 0, n }) {
+			for (int i = 0; i < n; i++) {
+				for (int j = 0; j < n; j++) {
+					std::array<int, 3> c00, c10, c11, c01;
+					c00[axis] = c10[axis] = c11[axis] = c01[axis] = side;
+					c00[a1] = i;     c00[a2] = j;
+					c10[a1] = i + 1; c10[a2] = j;
+					c11[a1] = i + 1; c11[a2] = j + 1;
+					c01[a1] = i;     c01[a2] = j + 1;
+					GLuint p00 = gridPoint(c00);
+					GLuint p10 = gridPoint(c10);
+					GLuint p11 = gridPoint(c11);
+					GLuint p01 = gridPoint(c01);
+					addTriangle(triangles, points, p00, p10, p11);
+					addTriangle(triangles, points, p00, p11, p01);
+				}
+			}
+		}
+	}
+
+	return unwrapSphere(points, triangles, radius, center);
+}
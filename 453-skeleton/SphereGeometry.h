@@ -0,0 +1,21 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Sphere meshes made of evenly sized triangles. Both generators return the same
+// CPU_Geometry as the latitude/longitude lattice they replace: positions, unit
+// normals and equirectangular texture coordinates, u around the y axis and v
+// from the top pole (v = 0) to the bottom one (v = 1).
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+
+#include <glm/glm.hpp>
+
+
+// Icosahedron whose faces are split in four subdivisions times, 20 * 4^subdivisions triangles
+CPU_Geometry icosphereGeometry(float radius, glm::vec3 center, int subdivisions);
+
+// Cube with subdivisions x subdivisions quads per face pushed out onto the sphere,
+// 12 * subdivisions^2 triangles. Even subdivisions put grid lines on the poles and
+// the texture seam, so no triangle there has to be cut in two.
+CPU_Geometry cubeSphereGeometry(float radius, glm::vec3 center, int subdivisions);
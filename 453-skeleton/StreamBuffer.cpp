@@ -0,0 +1,119 @@
+#include "StreamBuffer.h"
+
+#include "GLExtensions.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+
+namespace {
+
+	// shared by every stream buffer, they all go through the frames together
+	unsigned long long currentFrame = 0;
+	GLsync frameFences[STREAM_FRAMES_IN_FLIGHT] = {};
+	unsigned long long waitedFrame = ~0ull;
+
+	// Waits until the GPU is done with the frame that last used this frame's
+	// regions, which is normally long over. Once per frame is enough.
+	void waitForFrameRegion() {
+		if (waitedFrame == currentFrame) {
+			return;
+		}
+		waitedFrame = currentFrame;
+
+		GLsync& fence = frameFences[currentFrame % STREAM_FRAMES_IN_FLIGHT];
+		if (fence == nullptr) {
+			return;
+		}
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			Log::warning("STREAM BUFFER waiting on the GPU, more than {} frames ahead", STREAM_FRAMES_IN_FLIGHT);
+			while (result == GL_TIMEOUT_EXPIRED) {
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+			}
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
+
+
+StreamBuffer::StreamBuffer(size_t bytesPerFrame)
+	: bufferID{}
+{
+	allocate(bytesPerFrame);
+}
+
+
+size_t StreamBuffer::write(const void* data, size_t size, size_t alignment) {
+	bool newFrame = frame != currentFrame;
+	if (newFrame) {
+		frame = currentFrame;
+		used = 0;
+	}
+
+	size_t offset = (used + alignment - 1) / alignment * alignment;
+	if (offset + size > regionSize) {
+		// a new buffer object, draws already made this frame keep reading the old one
+		allocate(std::max(2 * regionSize, size));
+		newFrame = true;
+		offset = 0;
+	}
+	used = offset + size;
+
+	if (isPersistent()) {
+		waitForFrameRegion();
+		size_t region = regionSize * size_t(currentFrame % STREAM_FRAMES_IN_FLIGHT);
+		std::memcpy(mapping + region + offset, data, size);
+		return region + offset;
+	}
+
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+	if (newFrame) {
+		// orphan: the GPU keeps the old storage for as long as it reads it
+		glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+	}
+	glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+	return offset;
+}
+
+
+void StreamBuffer::endFrame() {
+	if (GLExtensions::bufferStorage != nullptr) {
+		GLsync& fence = frameFences[currentFrame % STREAM_FRAMES_IN_FLIGHT];
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+		}
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	currentFrame++;
+}
+
+
+void StreamBuffer::allocate(size_t bytesPerFrame) {
+	bufferID = VertexBufferHandle();
+	mapping = nullptr;
+	// whole multiples of 256 keep every region start aligned for any write,
+	// uniform blocks included
+	regionSize = (std::max<size_t>(bytesPerFrame, 256) + 255) / 256 * 256;
+
+	used = 0;
+
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+	if (GLExtensions::bufferStorage != nullptr) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		size_t total = regionSize * STREAM_FRAMES_IN_FLIGHT;
+		GLExtensions::bufferStorage(GL_COPY_WRITE_BUFFER, total, nullptr, flags);
+		mapping = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags));
+		if (mapping == nullptr) {
+			Log::warning("STREAM BUFFER could not map {} bytes, falling back to orphaning", total);
+			bufferID = VertexBufferHandle();
+			GLState::bindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+		}
+	}
+	if (mapping == nullptr) {
+		glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+	}
+}
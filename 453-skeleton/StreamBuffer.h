@@ -0,0 +1,68 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Buffer for data rewritten every frame, like instance matrices and sprites.
+//
+// With ARB_buffer_storage the buffer is mapped once for good and split into one
+// region per frame in flight. Each frame writes into its own region, and a fence
+// placed at the end of every frame says when the GPU is done reading it, so the
+// CPU only ever waits if it gets STREAM_FRAMES_IN_FLIGHT frames ahead.
+//
+// Without it (plain GL 3.3) the first write of a frame orphans the buffer with
+// glBufferData, so the driver hands out fresh storage instead of stalling on
+// the old one, and the writes go in with glBufferSubData.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "GLState.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstddef>
+
+
+const int STREAM_FRAMES_IN_FLIGHT = 3;
+
+
+class StreamBuffer {
+
+public:
+	// bytesPerFrame is a starting size, the buffer grows if a frame writes more
+	StreamBuffer(size_t bytesPerFrame);
+
+	// Because we're using the VertexBufferHandle to do RAII for the buffer for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	// note: writing may replace the buffer object, so bind it after the write
+	void bind(GLenum target) const { GLState::bindBuffer(target, bufferID); }
+	void bindRange(GLenum target, GLuint index, size_t offset, size_t size) const {
+		GLState::bindBufferRange(target, index, bufferID, offset, size);
+	}
+
+
+	// Copies size bytes into this frame's part of the buffer, starting on a
+	// multiple of alignment, and returns the byte offset they start at
+	size_t write(const void* data, size_t size, size_t alignment = 16);
+
+	bool isPersistent() const { return mapping != nullptr; }
+
+	// Ends the frame for every stream buffer. Call once per frame, after the
+	// last draw that reads from any of them.
+	static void endFrame();
+
+private:
+	void allocate(size_t bytesPerFrame);
+
+	VertexBufferHandle bufferID;
+	unsigned char* mapping = nullptr; // whole buffer, only when persistent
+	size_t regionSize = 0;
+	size_t used = 0;
+	unsigned long long frame = ~0ull; // last frame written to
+};
@@ -2,10 +2,57 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
+
+
+namespace {
+
+	// Mean colour of an image, greyscale images only have one channel to average
+	glm::vec3 averageColor(const unsigned char* data, int width, int height, int numComponents) {
+		glm::dvec3 sum(0.0);
+		size_t pixels = size_t(width) * size_t(height);
+		for (size_t i = 0; i < pixels; i++) {
+			const unsigned char* pixel = data + i * numComponents;
+			sum += glm::dvec3(pixel[0], pixel[numComponents > 2 ? 1 : 0], pixel[numComponents > 2 ? 2 : 0]);
+		}
+		if (pixels == 0) {
+			return glm::vec3(0.0f);
+		}
+		return glm::vec3(sum / (255.0 * double(pixels)));
+	}
+
+	// Bilinear resampling of an RGBA image to width x height
+	std::vector<unsigned char> resample(const unsigned char* data, int fromWidth, int fromHeight, int width, int height) {
+		std::vector<unsigned char> result(size_t(width) * size_t(height) * 4);
+		for (int y = 0; y < height; y++) {
+			// sample at pixel centers so both images cover the same area
+			float fy = std::max((y + 0.5f) * fromHeight / height - 0.5f, 0.0f);
+			int y0 = std::min(int(fy), fromHeight - 1);
+			int y1 = std::min(y0 + 1, fromHeight - 1);
+			float ty = fy - y0;
+			for (int x = 0; x < width; x++) {
+				float fx = std::max((x + 0.5f) * fromWidth / width - 0.5f, 0.0f);
+				int x0 = std::min(int(fx), fromWidth - 1);
+				int x1 = std::min(x0 + 1, fromWidth - 1);
+				float tx = fx - x0;
+				for (int c = 0; c < 4; c++) {
+					auto at = [&](int px, int py) { return float(data[(size_t(py) * fromWidth + px) * 4 + c]); };
+					float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * tx;
+					float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * tx;
+					result[(size_t(y) * width + x) * 4 + c] = (unsigned char)(top + (bottom - top) * ty + 0.5f);
+				}
+			}
+		}
+		return result;
+	}
+}
+
 
 Texture::Texture(std::string path, GLint interpolation)
-	: textureID(), path(path), interpolation(interpolation)
+	: textureID(), target(GL_TEXTURE_2D), path(path), interpolation(interpolation), layers(1)
 {
 	int numComponents;
 	stbi_set_flip_vertically_on_load(true);
@@ -37,6 +84,8 @@ Texture::Texture(std::string path, GLint interpolation)
 			std::cout << "Invalid Texture Format" << std::endl;
 			break;
 		};
+		averageColors.push_back(averageColor(data, width, height, numComponents));
+
 		//Loads texture data into bound texture
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 
@@ -55,3 +104,40 @@ Texture::Texture(std::string path, GLint interpolation)
 		throw std::runtime_error("Failed to read texture data from file!");
 	}
 }
+
+
+Texture::Texture(const std::vector<std::string>& paths, GLint interpolation, glm::ivec2 layerSize)
+	: textureID()
+	, target(GL_TEXTURE_2D_ARRAY)
+	, path(paths.empty() ? std::string() : paths.front())
+	, interpolation(interpolation)
+	, width(layerSize.x)
+	, height(layerSize.y)
+	, layers(int(paths.size()))
+{
+	stbi_set_flip_vertically_on_load(true);
+	bind();
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	for (int layer = 0; layer < layers; layer++) {
+		int imageWidth;
+		int imageHeight;
+		int numComponents;
+		// always expanded to RGBA so every layer has the same format
+		unsigned char* data = stbi_load(paths[layer].c_str(), &imageWidth, &imageHeight, &numComponents, 4);
+		if (data == nullptr) {
+			throw std::runtime_error("Failed to read texture data from file " + paths[layer] + "!");
+		}
+		averageColors.push_back(averageColor(data, imageWidth, imageHeight, 4));
+
+		std::vector<unsigned char> pixels = resample(data, imageWidth, imageHeight, width, height);
+		stbi_image_free(data);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	}
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, interpolation);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, interpolation);
+	unbind();
+}
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "GLState.h"
 //#include <GL/glew.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
@@ -12,6 +14,9 @@
 class Texture {
 public:
 	Texture(std::string path, GLint interpolation);
+	// A GL_TEXTURE_2D_ARRAY with one layer per image, every image resampled to
+	// layerSize. Lets draws that need different images share one binding.
+	Texture(const std::vector<std::string>& paths, GLint interpolation, glm::ivec2 layerSize);
 
 	// Because we're using the TextureHandle to do RAII for the texture for us
 	// and our other types are trivial or provide their own RAII
@@ -21,18 +26,28 @@ public:
 	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
 
 	// Public interface
-	std::string getPath() const { return path; }
+	std::string getPath() const { return path; } // the first layer's for arrays
 	GLenum getInterpolation() const { return interpolation; }
 
 	// Although uint (i.e. uvec2) might make more sense here, went with int (i.e. ivec2) under
 	// the assumption that most students will want to work with ints, not uints, in main.cpp
 	glm::ivec2 getDimensions() const { return glm::uvec2(width, height); }
+	int getLayers() const { return layers; }
+	GLenum getTarget() const { return target; }
+
+	// Mean colour of the image, for when the texture is too small on screen to sample
+	glm::vec3 getAverageColor(int layer = 0) const { return averageColors[layer]; }
+
+	GLuint getID() const { return textureID; }
+
+	void bind() { GLState::bindTexture(target, textureID); }
+
+	void unbind() { GLState::bindTexture(target, 0); }
 
-	void bind() { glBindTexture(GL_TEXTURE_2D, textureID); }
-	void unbind() { glBindTexture(GL_TEXTURE_2D, textureID); }
 
 private:
 	TextureHandle textureID;
+	GLenum target; // GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
 	std::string path;
 	GLint interpolation;
 
@@ -41,7 +56,7 @@ private:
 	// that most students will want to work with ints, not uints, in main.cpp
 	int width;
 	int height;
+	int layers;
 
-
-
+	std::vector<glm::vec3> averageColors; // one per layer
 };
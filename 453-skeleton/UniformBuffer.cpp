@@ -0,0 +1,56 @@
+#include "UniformBuffer.h"
+
+#include <cstring>
+
+
+GLint uniformBlockBinding(const std::string& name) {
+	if (name == "Frame") {
+		return FRAME_BLOCK_BINDING;
+	}
+	if (name == "Object" || name == "Ring") {
+		return OBJECT_BLOCK_BINDING;
+	}
+	return -1;
+}
+
+
+UniformBuffer::UniformBuffer()
+	: stream(64 * 256)
+	, alignment(256)
+	, base(0)
+{
+	GLint offsetAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	if (offsetAlignment > 0) {
+		alignment = size_t(offsetAlignment);
+	}
+}
+
+
+void UniformBuffer::clear() {
+	staging.clear();
+	blocks.clear();
+}
+
+
+size_t UniformBuffer::add(const void* data, size_t size) {
+	// every block has to start on the offset alignment to be bound on its own
+	size_t offset = (staging.size() + alignment - 1) / alignment * alignment;
+	staging.resize(offset + size);
+	std::memcpy(staging.data() + offset, data, size);
+	blocks.push_back(Range{ offset, size });
+	return blocks.size() - 1;
+}
+
+
+void UniformBuffer::upload() {
+	if (!staging.empty()) {
+		base = stream.write(staging.data(), staging.size(), alignment);
+	}
+}
+
+
+void UniformBuffer::bind(GLuint binding, size_t index) const {
+	Range const& block = blocks[index];
+	stream.bindRange(GL_UNIFORM_BUFFER, binding, base + block.offset, block.size);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// std140 uniform blocks shared between shader programs.
+//
+// Every block used in a frame is added here first and then copied to the GPU
+// with a single upload. Drawing with one of them is only a glBindBufferRange
+// on its binding point, instead of a glUniform call per value per draw.
+//
+// GLSL 3.30 can't give a block its binding point itself, so ShaderProgram binds
+// the blocks it finds by name, see uniformBlockBinding.
+//------------------------------------------------------------------------------
+
+#include "StreamBuffer.h"
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+
+// Binding points of the shared blocks
+const GLuint FRAME_BLOCK_BINDING = 0;  // block Frame, the same for every draw of a frame
+const GLuint OBJECT_BLOCK_BINDING = 1; // blocks Object and Ring, one per draw
+
+
+// These mirror the std140 layout of the blocks in the shaders: vec3 is padded
+// to 16 bytes unless a float follows, and a block's size rounds up to 16 bytes.
+struct FrameBlock {
+	glm::mat4 V;
+	glm::mat4 P;
+	glm::vec3 lightPosition;
+	float padding = 0.0f;
+};
+
+struct ObjectBlock {
+	glm::mat4 M;
+	glm::vec3 center;
+	float sun; // 1 for bodies that give off light and are not shaded
+};
+
+struct RingBlock {
+	glm::mat4 M;
+	float innerRadius;
+	float outerRadius;
+	GLint segments;
+	float padding = 0.0f;
+};
+
+static_assert(sizeof(FrameBlock) == 144, "FrameBlock doesn't match the std140 layout of Frame");
+static_assert(sizeof(ObjectBlock) == 80, "ObjectBlock doesn't match the std140 layout of Object");
+static_assert(sizeof(RingBlock) == 80, "RingBlock doesn't match the std140 layout of Ring");
+
+
+// Binding point of the block called name, -1 for blocks that aren't shared
+GLint uniformBlockBinding(const std::string& name);
+
+
+class UniformBuffer {
+
+public:
+	UniformBuffer();
+
+	// Because we're using the StreamBuffer to do RAII for the buffer for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	// Starts over with no blocks, for the next frame
+	void clear();
+
+	// Queues a block for the next upload and returns its index
+	template <typename Block>
+	size_t add(const Block& block) {
+		return add(&block, sizeof(Block));
+	}
+
+	// Copies every block added since clear to the GPU
+	void upload();
+
+	// Binds block index of the last upload to a binding point
+	void bind(GLuint binding, size_t index) const;
+
+private:
+	struct Range {
+		size_t offset; // in staging
+		size_t size;
+	};
+
+	size_t add(const void* data, size_t size);
+
+	StreamBuffer stream;
+	size_t alignment; // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	size_t base;      // where the last upload starts in stream
+	std::vector<unsigned char> staging;
+	std::vector<Range> blocks;
+};
@@ -42,9 +42,8 @@ void UnitCube::generateGeometry() {
 	colouredTriangles(square, { 0.f, 1.f, 1.f });
 
 	m_gpu_geom.bind();
-	m_gpu_geom.setVerts(square.verts);
-	m_gpu_geom.setCols(square.cols);
-	m_gpu_geom.setNormals(square.normals);
+	m_gpu_geom.upload(square);
+
 
 	m_size = square.verts.size();
 }
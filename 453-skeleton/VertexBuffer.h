@@ -1,6 +1,8 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "GLState.h"
+#include "VertexLayout.h"
 
 //#include <GL/glew.h>
 #include <glad/glad.h>
@@ -12,6 +14,16 @@ class VertexBuffer {
 public:
 	VertexBuffer(GLuint index, GLint size, GLenum dataType);
 
+	// Interleaved buffer holding every attribute of the given layout
+	template <typename... Attributes>
+	VertexBuffer(VertexLayout<Attributes...> layout)
+		: bufferID{}
+	{
+		bind();
+		layout.setAttribPointers();
+	}
+
+
 	// Because we're using the VertexBufferHandle to do RAII for the buffer for us
 	// and our other types are trivial or provide their own RAII
 	// we don't have to provide any specialized functions here. Rule of zero
@@ -20,7 +32,8 @@ public:
 	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
 
 	// Public interface
-	void bind() const { glBindBuffer(GL_ARRAY_BUFFER, bufferID); }
+	void bind() const { GLState::bindBuffer(GL_ARRAY_BUFFER, bufferID); }
+
 	void uploadData(GLsizeiptr size, const void* data, GLenum usage);
 
 private:
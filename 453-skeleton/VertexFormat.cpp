@@ -0,0 +1,102 @@
+#include "VertexFormat.h"
+
+#include "Geometry.h"
+#include "VertexLayout.h"
+
+#include <algorithm>
+
+
+std::string toString(VertexFormat format) {
+	switch (format) {
+	case VertexFormat::Packed:
+		return "packed";
+	case VertexFormat::PackedUnitSphere:
+		return "packed unit sphere";
+	default:
+		return "float";
+	}
+}
+
+
+int vertexStride(VertexFormat format) {
+	switch (format) {
+	case VertexFormat::Packed:
+		return PackedLayout::stride;
+	case VertexFormat::PackedUnitSphere:
+		return UnitSphereLayout::stride;
+	default:
+		return FloatLayout::stride;
+	}
+}
+
+
+std::vector<unsigned char> interleave(const CPU_Geometry& geom, VertexFormat format) {
+	switch (format) {
+	case VertexFormat::Packed:
+		return PackedLayout::interleave(geom);
+	case VertexFormat::PackedUnitSphere:
+		return UnitSphereLayout::interleave(geom);
+	default:
+		return FloatLayout::interleave(geom);
+	}
+}
+
+
+void setAttribPointers(VertexFormat format) {
+	switch (format) {
+	case VertexFormat::Packed:
+		PackedLayout::setAttribPointers();
+		break;
+	case VertexFormat::PackedUnitSphere:
+		UnitSphereLayout::setAttribPointers();
+		break;
+	default:
+		FloatLayout::setAttribPointers();
+		break;
+	}
+}
+
+
+namespace {
+
+	float angleDegrees(glm::vec3 a, glm::vec3 b) {
+		if (glm::dot(a, a) == 0.0f || glm::dot(b, b) == 0.0f) {
+			return 0.0f;
+		}
+		float c = glm::clamp(glm::dot(glm::normalize(a), glm::normalize(b)), -1.0f, 1.0f);
+		return glm::degrees(std::acos(c));
+	}
+
+	float uvError(glm::vec2 a, glm::vec2 b) {
+		glm::vec2 d = glm::abs(a - b);
+		return std::max(d.x, d.y);
+	}
+}
+
+
+QuantizationError measureQuantizationError(const CPU_Geometry& geom, VertexFormat format) {
+	// note: this decodes the way GL 4.2+ does. GL 3.3 maps signed normalized
+	// values slightly differently, which moves them by at most half a step more.
+	QuantizationError error;
+	for (size_t i = 0; i < geom.verts.size(); i++) {
+		glm::vec2 uv = UV2f::fetch(geom, i);
+		glm::vec3 normal = Normal3f::fetch(geom, i);
+
+		switch (format) {
+		case VertexFormat::Packed:
+			error.uv = std::max(error.uv, uvError(uv, UVUnorm16::decode(UVUnorm16::fetch(geom, i))));
+			error.normalDegrees = std::max(error.normalDegrees, angleDegrees(normal, NormalPacked::decode(NormalPacked::fetch(geom, i))));
+			break;
+		case VertexFormat::PackedUnitSphere: {
+			glm::vec3 decoded = UnitSphereNormalPacked::decode(UnitSphereNormalPacked::fetch(geom, i));
+			error.position = std::max(error.position, glm::length(geom.verts[i] - decoded));
+			error.uv = std::max(error.uv, uvError(uv, UVUnorm16::decode(UVUnorm16::fetch(geom, i))));
+			error.normalDegrees = std::max(error.normalDegrees, angleDegrees(normal, decoded));
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	return error;
+}
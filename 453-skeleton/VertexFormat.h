@@ -0,0 +1,41 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Runtime choice between the vertex layouts in VertexLayout.h, and a check of
+// how much precision the quantized ones lose on a given mesh
+//------------------------------------------------------------------------------
+
+#include <string>
+#include <vector>
+
+struct CPU_Geometry;
+
+
+enum class VertexFormat {
+	Float,            // float positions, texture coordinates and normals
+	Packed,           // float positions, 16 bit texture coordinates, 10 bit normals
+	PackedUnitSphere, // 16 bit texture coordinates, 10 bit normals also used as positions
+};
+
+std::string toString(VertexFormat format);
+
+// Size in bytes of one vertex in the given format
+int vertexStride(VertexFormat format);
+
+// Vertices of geom laid out in format, ready for a vertex buffer
+std::vector<unsigned char> interleave(const CPU_Geometry& geom, VertexFormat format);
+
+// Points the attributes of format at the buffer bound to GL_ARRAY_BUFFER, in the bound VAO
+void setAttribPointers(VertexFormat format);
+
+
+// Largest difference between geom and what the shader reads back in format.
+// Positions and texture coordinates are absolute distances, normals are the
+// angle between the original and decoded normal in degrees.
+struct QuantizationError {
+	float position = 0.0f;
+	float uv = 0.0f;
+	float normalDegrees = 0.0f;
+};
+
+QuantizationError measureQuantizationError(const CPU_Geometry& geom, VertexFormat format);
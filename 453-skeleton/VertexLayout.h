@@ -0,0 +1,175 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Compile time descriptions of interleaved vertex formats.
+//
+// A VertexLayout lists the attributes stored for every vertex, in order.
+// From that list it works out the stride and the offset of every attribute,
+// makes the matching glVertexAttribPointer calls and packs a CPU_Geometry
+// into one interleaved array that can be uploaded with a single call.
+//
+// Example: using Layout = VertexLayout<Position3f, UV2f, Normal3f>;
+//------------------------------------------------------------------------------
+
+//#include <GL/glew.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+// Attribute descriptors. Each one says which shader locations it feeds, how
+// OpenGL should read it, what it is stored as, how to get it out of a
+// CPU_Geometry and what the shader will read back (decode).
+// Missing texture coordinates or normals are written as zero.
+struct Position3f {
+	using value_type = glm::vec3;
+	static constexpr GLuint locations[] = { 0 };
+	static constexpr GLint components = 3;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+
+	template <typename Geometry>
+	static value_type fetch(const Geometry& geom, size_t i) { return geom.verts[i]; }
+	static glm::vec3 decode(value_type v) { return v; }
+};
+
+struct UV2f {
+	using value_type = glm::vec2;
+	static constexpr GLuint locations[] = { 1 };
+	static constexpr GLint components = 2;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+
+	template <typename Geometry>
+	static value_type fetch(const Geometry& geom, size_t i) {
+		return i < geom.cols.size() ? geom.cols[i] : glm::vec2(0.0f);
+	}
+	static glm::vec2 decode(value_type v) { return v; }
+};
+
+struct Normal3f {
+	using value_type = glm::vec3;
+	static constexpr GLuint locations[] = { 2 };
+	static constexpr GLint components = 3;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+
+	template <typename Geometry>
+	static value_type fetch(const Geometry& geom, size_t i) {
+		return i < geom.normals.size() ? geom.normals[i] : glm::vec3(0.0f);
+	}
+	static glm::vec3 decode(value_type v) { return v; }
+};
+
+
+// Quantized attributes
+
+// Texture coordinates as two 16 bit fixed point values, 4 bytes instead of 8.
+// More precise than half floats but only covers [0, 1], which is all our
+// generators produce.
+struct UVUnorm16 {
+	using value_type = uint32_t;
+	static constexpr GLuint locations[] = { 1 };
+	static constexpr GLint components = 2;
+	static constexpr GLenum type = GL_UNSIGNED_SHORT;
+	static constexpr GLboolean normalized = GL_TRUE;
+
+	template <typename Geometry>
+	static value_type fetch(const Geometry& geom, size_t i) { return glm::packUnorm2x16(UV2f::fetch(geom, i)); }
+	static glm::vec2 decode(value_type v) { return glm::unpackUnorm2x16(v); }
+};
+
+// Unit normal as 10 bits per component, 4 bytes instead of 12
+struct NormalPacked {
+	using value_type = uint32_t;
+	static constexpr GLuint locations[] = { 2 };
+	static constexpr GLint components = 4; // required by the packed type, w is unused
+	static constexpr GLenum type = GL_INT_2_10_10_10_REV;
+	static constexpr GLboolean normalized = GL_TRUE;
+
+	template <typename Geometry>
+	static value_type fetch(const Geometry& geom, size_t i) {
+		glm::vec3 n = Normal3f::fetch(geom, i);
+		if (glm::dot(n, n) > 0.0f) {
+			n = glm::normalize(n);
+		}
+		return glm::packSnorm3x10_1x2(glm::vec4(n, 0.0f));
+	}
+	static glm::vec3 decode(value_type v) { return glm::vec3(glm::unpackSnorm3x10_1x2(v)); }
+};
+
+// For meshes of the unit sphere centered on the origin the position of a
+// vertex is its normal, so one packed normal feeds both the position and the
+// normal attribute and no position is stored at all
+struct UnitSphereNormalPacked {
+	using value_type = uint32_t;
+	static constexpr GLuint locations[] = { 0, 2 };
+	static constexpr GLint components = 4;
+	static constexpr GLenum type = GL_INT_2_10_10_10_REV;
+	static constexpr GLboolean normalized = GL_TRUE;
+
+	template <typename Geometry>
+	static value_type fetch(const Geometry& geom, size_t i) {
+		return glm::packSnorm3x10_1x2(glm::vec4(glm::normalize(geom.verts[i]), 0.0f));
+	}
+	static glm::vec3 decode(value_type v) { return NormalPacked::decode(v); }
+};
+
+
+template <typename... Attributes>
+struct VertexLayout {
+
+	// Size in bytes of one vertex
+	static constexpr GLsizei stride = GLsizei((sizeof(typename Attributes::value_type) + ...));
+
+	// Points every attribute at its place in the buffer bound to GL_ARRAY_BUFFER,
+	// for vertices starting base bytes into it.
+	// Like the rest of the attribute setup, this is stored in the bound VAO.
+	static void setAttribPointers(size_t base = 0) {
+		size_t offset = base;
+		(setAttribPointer<Attributes>(offset), ...);
+	}
+
+
+	// Packs every vertex of geom into one array in this layout
+	template <typename Geometry>
+	static std::vector<unsigned char> interleave(const Geometry& geom) {
+		std::vector<unsigned char> data(size_t(stride) * geom.verts.size());
+		unsigned char* vertex = data.data();
+		for (size_t i = 0; i < geom.verts.size(); i++) {
+			size_t offset = 0;
+			(write<Attributes>(vertex, offset, geom, i), ...);
+			vertex += stride;
+		}
+		return data;
+	}
+
+private:
+	template <typename Attribute>
+	static void setAttribPointer(size_t& offset) {
+		for (GLuint location : Attribute::locations) {
+			glVertexAttribPointer(location, Attribute::components, Attribute::type, Attribute::normalized, stride, (void*)offset);
+			glEnableVertexAttribArray(location);
+		}
+		offset += sizeof(typename Attribute::value_type);
+	}
+
+	template <typename Attribute, typename Geometry>
+	static void write(unsigned char* vertex, size_t& offset, const Geometry& geom, size_t i) {
+		typename Attribute::value_type value = Attribute::fetch(geom, i);
+		std::memcpy(vertex + offset, &value, sizeof(value));
+		offset += sizeof(value);
+	}
+};
+
+
+// Layouts GPU_Geometry can store its vertices in, see VertexFormat.h
+using FloatLayout = VertexLayout<Position3f, UV2f, Normal3f>;         // 32 bytes per vertex
+using PackedLayout = VertexLayout<Position3f, UVUnorm16, NormalPacked>; // 20 bytes per vertex
+using UnitSphereLayout = VertexLayout<UVUnorm16, UnitSphereNormalPacked>; // 8 bytes per vertex
@@ -1,5 +1,6 @@
 #include "Window.h"
 
+#include "GLExtensions.h"
 #include "Log.h"
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_glfw.h"
@@ -78,6 +79,8 @@ Window::Window(
 	if (!gladLoadGL()) {
 		throw std::runtime_error("Failed to initialize GLAD");
 	}
+	GLExtensions::load();
+
 
 	glfwSetWindowSizeCallback(window.get(), defaultWindowSizeCallback);
 
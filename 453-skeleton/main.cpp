@@ -7,16 +7,35 @@
 #include <list>
 #include <vector>
 #include <limits>
+#include <cmath>
 #include <functional>
+#include <algorithm>
+#include <optional>
 
 #include "Geometry.h"
+#include "GeometryBuilder.h"
 #include "GLDebug.h"
+#include "GLState.h"
+#include "InstanceBuffer.h"
+#include "InstanceCuller.h"
 #include "Log.h"
+#include "MeshArena.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "OcclusionQueries.h"
+#include "PointSprites.h"
+#include "RenderQueue.h"
 #include "ShaderProgram.h"
 #include "Shader.h"
+#include "SphereGeometry.h"
+#include "StreamBuffer.h"
 #include "Texture.h"
+#include "UniformBuffer.h"
+#include "VertexArray.h"
 #include "Window.h"
 #include "Camera.h"
+#include "DrawCommandBuffer.h"
+#include "Frustum.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
@@ -24,19 +43,22 @@
 #include "UnitCube.h"
 
 
-void updateGPUGeometry(GPU_Geometry& gpuGeom, CPU_Geometry const& cpuGeom) {
-	gpuGeom.bind();
-	gpuGeom.setVerts(cpuGeom.verts);
-	gpuGeom.setNormals(cpuGeom.normals);
-	gpuGeom.setCols(cpuGeom.cols);
-}
-
 struct GameTexture {
 	GameTexture(std::string path, GLenum interpolation) :
-		textures(path, interpolation)
+		textures(std::make_shared<Texture>(path, interpolation)),
+		layer(0)
+	{}
+
+	// A layer of a texture array that other GameTextures share
+	GameTexture(std::shared_ptr<Texture> array, int layer) :
+		textures(array),
+		layer(layer)
 	{}
 
-	Texture textures;
+	glm::vec3 averageColor() const { return textures->getAverageColor(layer); }
+
+	std::shared_ptr<Texture> textures;
+	int layer;
 };
 
 glm::mat4 translate(glm::vec3 point) {
@@ -51,105 +73,104 @@ glm::mat4 rotationAxis(float angle, glm::vec3 axis) {
 	return glm::rotate(glm::mat4(1.0f), glm::radians(angle), axis);
 }
 
-CPU_Geometry sphereGeometry(float radius, glm::vec3 center) {
-	CPU_Geometry lgeom;
-	CPU_Geometry cgeom;
-	CPU_Geometry fgeom;
-
-	//initial line
-	for (float angle = 0.0f; angle < 181.0f; angle = angle + 4.0f) {
-		float a = glm::radians(angle);
-		glm::vec3 point = glm::vec3{ radius * sin(a), radius * cos(a), 0.0f };
-		lgeom.verts.push_back(point);
-	}
-
-	//rotation
-	for (int i = 0; i < 91; i++) { //line about axis
-		for (int j = 0; j < lgeom.verts.size(); j++) { //point in line
-			glm::vec3 point = rotation(4.0f * i) * glm::vec4(lgeom.verts[j], 1.0f);
-			cgeom.verts.push_back(point + center);
-			cgeom.cols.push_back(glm::vec2{ i * 4.0 /360.0f, j * 4.0 / 180.0f});
-			cgeom.normals.push_back(point);
-		}
-	}
-
-	//triangles
-	std::vector<int> h = { 0, 1, ((int)lgeom.verts.size()), 1, (1 + (int)lgeom.verts.size()), ((int)lgeom.verts.size()) };
-	int pos = -lgeom.verts.size();
-	for (int i = 0; i < 90; i++) {
-		pos = pos + lgeom.verts.size();
-		for (int j = 0; j < lgeom.verts.size() - 1; j++) {
-			for (int k = 0; k < h.size(); k++) {
-				fgeom.verts.push_back(cgeom.verts[pos + h[k] + j]);
-				fgeom.cols.push_back(cgeom.cols[pos + h[k] + j]);
-				fgeom.normals.push_back(cgeom.normals[pos + h[k] + j]);
-			}
+// Flat ring in a body's equatorial plane. Nothing is stored for it on the GPU,
+// shaders/ring.vert makes every vertex from gl_VertexID, so any body can have one.
+struct PlanetRing {
+	std::shared_ptr<GameTexture> texture;
+	float innerRadius; // world units from the body's center
+	float outerRadius;
+};
+
+// Ring segments are picked from the ring's radius in pixels, about one per pixel
+const GLint RING_MIN_SEGMENTS = 16;
+const GLint RING_MAX_SEGMENTS = 256;
+
+// Mesh stored once in the arena and shared between every GameObject that draws it
+struct GameMesh {
+	GameMesh(MeshArena& arena, CPU_Geometry const& cgeom, VertexFormat format = VertexFormat::Float) :
+		range(arena.add(cgeom, format)),
+		boundingRadius(0.0f)
+	{
+		for (glm::vec3 const& v : cgeom.verts) {
+			boundingRadius = std::max(boundingRadius, glm::length(v));
 		}
+		QuantizationError error = measureQuantizationError(cgeom, format);
+		Log::info("MESH {} vertices as {} ({} bytes each), max error: position {:.5f}, uv {:.6f}, normal {:.3f} degrees",
+			cgeom.verts.size(), toString(format), vertexStride(format), error.position, error.uv, error.normalDegrees);
 	}
 
-	return fgeom;
-}
-
-CPU_Geometry saturnsRings(float radius, glm::vec3 center) {
-	CPU_Geometry lgeom;
-	CPU_Geometry cgeom;
-	CPU_Geometry fgeom;
-
-	//initial line
-	for (float i = 0.0f; i < radius * 1.5; i = i + 0.1f) {
-		glm::vec3 point = glm::vec3{ radius + 0.1 + i, 0.0f, 0.0f };
-		lgeom.verts.push_back(point);
-	}
-
-	//rotation
-	for (int i = 0; i < 91; i++) { //line about axis
-		for (int j = 0; j < lgeom.verts.size(); j++) { //point in line
-			glm::vec3 point = rotation(4.0f * i) * glm::vec4(lgeom.verts[j], 1.0f);
-			cgeom.verts.push_back(point + center);
-			cgeom.cols.push_back(glm::vec2{ float(j + 1) / float(lgeom.verts.size() + 1), i * 4.0 / 360.0f });
-			cgeom.normals.push_back(point);
-		}
-	}
-
-	//triangles
-	std::vector<int> h = { 0, 1, ((int)lgeom.verts.size()), 1, (1 + (int)lgeom.verts.size()), ((int)lgeom.verts.size()) };
-	int pos = -lgeom.verts.size();
-	for (int i = 0; i < 90; i++) {
-		pos = pos + lgeom.verts.size();
-		for (int j = 0; j < lgeom.verts.size() - 1; j++) {
-			for (int k = 0; k < h.size(); k++) {
-				fgeom.verts.push_back(cgeom.verts[pos + h[k] + j]);
-				fgeom.cols.push_back(cgeom.cols[pos + h[k] + j]);
-				fgeom.normals.push_back(cgeom.normals[pos + h[k] + j]);
-			}
-		}
+	// Uploads straight from the cache file's mapping
+	GameMesh(MeshArena& arena, CachedMesh const& cached, VertexFormat format) :
+		range(arena.add(format, cached.vertices(), cached.vertexBytes(), cached.indices(), cached.indexCount())),
+		boundingRadius(cached.boundingRadius())
+	{
+		Log::info("MESH {} vertices as {} ({} bytes each), from the cache",
+			cached.vertexBytes() / vertexStride(format), toString(format), vertexStride(format));
 	}
 
-	return fgeom;
-}
+	ArenaMesh range;
+	float boundingRadius; // around the mesh's origin
+};
 
 struct GameObject {
-	// Struct's constructor deals with the texture.
+	// Struct's constructor deals with the texture and the mesh.
+	// The mesh is centered on the origin, the body's center, tilt and scale
+	// are applied by its model matrix instead of being baked into the vertices.
+	// a is the angle of the rotation axis and b the angle of the orbit axis, the
+	// body is tilted by the difference between them.
 	// Also sets default position, theta, scale, and transformationMatrix
 	//GameObject(std::string texturePath, GLenum textureInterpolation) :
-	GameObject(std::shared_ptr<GameTexture> g, glm::vec3 c, float r, float a, float b) :
-		cgeom(sphereGeometry(r, c)),
-		ggeom(),
+	GameObject(std::shared_ptr<GameTexture> g, std::shared_ptr<GameMesh> m, glm::vec3 c, float r, float a, float b) :
 		texture(g),
+		mesh(m),
 		center(c),
 		radius(r),
 		rotAxisAngle(a),
 		orbitAxisAngle(b),
+		scale(r), // unit sphere mesh scaled up to the body's radius
+		sun(0.0f),
+		tilt(rotationAxis(-(a - b), glm::vec3{ 0.0f, 0.0f, 1.0f })),
+		spinAxis(tilt * glm::vec4(0.0f, r, 0.0f, 0.0f)),
 		transformationMatrix(1.0f) // This constructor sets it as the identity matrix
 	{}
 
+	// Mesh space -> world space, transformationMatrix holds the animation
+	glm::mat4 modelMatrix() const {
+		return transformationMatrix * translate(center) * tilt * glm::scale(glm::mat4(1.0f), glm::vec3(scale));
+	}
+
+	// Same without the scale, the ring's radii are already in world units
+	glm::mat4 ringMatrix() const {
+		return transformationMatrix * translate(center) * tilt;
+	}
+
+	// Top of the (tilted) body before any animation
+	glm::vec3 pole() const {
+		return center + spinAxis;
+	}
+
+	// Where the body is right now and how big it is
+	glm::vec3 worldCenter() const {
+		return glm::vec3(modelMatrix()[3]);
+	}
+	float worldRadius() const {
+		return mesh->boundingRadius * scale;
+	}
+	BoundingSphere bounds() const {
+		return BoundingSphere{ worldCenter(), worldRadius() };
+	}
+
 	std::shared_ptr<GameTexture> texture;
-	CPU_Geometry cgeom;
-	GPU_Geometry ggeom;
+	std::shared_ptr<GameMesh> mesh;
+	std::optional<PlanetRing> ring;
 	glm::vec3 center;
 	float radius;
 	float rotAxisAngle;
 	float orbitAxisAngle;
+	float scale;
+	float sun; // 1 for bodies that give off light and are not shaded
+	glm::mat4 tilt;     // fixed for the body's lifetime, never part of the mesh
+	glm::vec3 spinAxis; // what the body spins around, tilt applied to +y
 	glm::mat4 transformationMatrix;
 };
 
@@ -178,6 +199,18 @@ public:
 			else if (key == GLFW_KEY_R) { //Restart
 				restart = true;
 			}
+			else if (key == GLFW_KEY_P) { //Spheres from the vertex shader or from the mesh arena
+				proceduralSpheres = !proceduralSpheres;
+				Log::info("Spheres drawn from {}", proceduralSpheres ? "gl_VertexID" : "meshes");
+			}
+			else if (key == GLFW_KEY_O) { //Occlusion queries for bodies hidden behind other bodies
+				occlusionCulling = !occlusionCulling;
+				Log::info("Occlusion culling {}", occlusionCulling ? "on" : "off");
+			}
+			else if (key == GLFW_KEY_G) { //Frustum culling of the instanced bodies on the GPU or the CPU
+				gpuCulling = !gpuCulling;
+				Log::info("Instanced bodies culled on the {}", gpuCulling ? "GPU" : "CPU");
+			}
 			else if (key == GLFW_KEY_RIGHT) { //Increase speed
 				speed = speed + 0.2;
 			}
@@ -209,25 +242,19 @@ public:
 		// The CallbackInterface::windowSizeCallback will call glViewport for us
 		CallbackInterface::windowSizeCallback(width,  height);
 		aspect = float(width)/float(height);
+		viewportHeight = float(height);
 	}
 
-	void viewPipeline(ShaderProgram &sp) {
-		glm::mat4 M = glm::mat4(1.0);
+	// The Frame block every program reads the camera from
+	FrameBlock viewPipeline() {
 		glm::mat4 V = camera.getView();
 		//V = glm::lookAt(
 		//	glm::vec3(V[3][0], V[3][0], V[3][0]), //camera position
 		//	centerPoint, //point to center at
 		//	glm::vec3(V[0][0], V[1][0], V[2][0]));//up axis
-		glm::mat4 P = glm::perspective(glm::radians(45.0f), aspect, 0.01f, 1000.f);
-		GLint location = glGetUniformLocation(sp, "lightPosition");
+		glm::mat4 P = glm::perspective(fovY, aspect, nearPlane, farPlane);
 		glm::vec3 light = camera.getPos();
-		glUniform3fv(location, 1, glm::value_ptr(light));
-		GLint uniMat = glGetUniformLocation(sp, "M");
-		glUniformMatrix4fv(uniMat, 1, GL_FALSE, glm::value_ptr(M));
-		uniMat = glGetUniformLocation(sp, "V");
-		glUniformMatrix4fv(uniMat, 1, GL_FALSE, glm::value_ptr(V));
-		uniMat = glGetUniformLocation(sp, "P");
-		glUniformMatrix4fv(uniMat, 1, GL_FALSE, glm::value_ptr(P));
+		return FrameBlock{ V, P, light };
 	}
 
 	float getSpeed() {
@@ -242,144 +269,528 @@ public:
 	void setRestart() {
 		restart = false;
 	}
+	bool getProceduralSpheres() {
+		return proceduralSpheres;
+	}
+	bool getGpuCulling() {
+		return gpuCulling;
+	}
+	bool getOcclusionCulling() {
+		return occlusionCulling;
+	}
+	float getNearPlane() {
+		return nearPlane;
+	}
+
+	// Distance to a point from 0 at the camera to 1 at the far plane, for sorting draws
+	float viewDepth(glm::vec3 point) {
+		return std::clamp(glm::length(point - camera.getPos()) / farPlane, 0.0f, 1.0f);
+	}
+
+	// Radius in pixels of a sphere after projection, for picking its detail level
+	float projectedRadius(glm::vec3 center, float radius) {
+		float distance = glm::length(center - camera.getPos());
+		if (distance <= radius) {
+			return std::numeric_limits<float>::max();
+		}
+		return radius / (distance * std::tan(fovY / 2.0f)) * (viewportHeight / 2.0f);
+	}
 
 	Camera camera;
 private:
 	bool rightMouseDown;
 	float aspect;
+	float viewportHeight = 800.0f;
+	float fovY = glm::radians(45.0f);
+	float nearPlane = 0.01f;
+	float farPlane = 1000.0f;
 	double mouseOldX;
 	double mouseOldY;
 	float speed = 1.0f;
 	bool pause = false;
 	bool restart = false;
+	bool proceduralSpheres = false;
+	bool gpuCulling = false;
+	bool occlusionCulling = false;
 	glm::vec3 centerPoint = glm::vec3(0.0f, 0.0f, 0.0f);
 };
 
-//tilts the planet to its appropriate axis
-void tiltAxis(GameObject& planet) {
-	glm::mat4 rotate = rotationAxis(-(planet.rotAxisAngle - planet.orbitAxisAngle), glm::vec3{ 0.0f, 0.0f, 1.0f });
-	for (int i = 0; i < planet.cgeom.verts.size(); i++) {
-		planet.cgeom.verts[i] = translate(planet.center) * rotate * translate(-planet.center) * glm::vec4(planet.cgeom.verts[i], 1.0f);
+// Everything the animation changes, so restarting it is copying this back
+// instead of rebuilding the scene
+struct SimulationState {
+	std::vector<glm::mat4> transforms; // transformationMatrix of each body, in order
+	double time;
+};
+
+SimulationState saveSimulation(std::vector<GameObject*> const& bodies, double time) {
+	SimulationState state{ {}, time };
+	state.transforms.reserve(bodies.size());
+	for (GameObject* planet : bodies) {
+		state.transforms.push_back(planet->transformationMatrix);
+	}
+	return state;
+}
+
+void restoreSimulation(SimulationState const& state, std::vector<GameObject*> const& bodies) {
+	for (size_t i = 0; i < bodies.size(); i++) {
+		bodies[i]->transformationMatrix = state.transforms[i];
+	}
+	glfwSetTime(state.time);
+}
+
+// The Object block of a body drawn on its own
+ObjectBlock objectBlock(GameObject const& planet) {
+	// meshes are centered on the origin of their own space
+	return ObjectBlock{ planet.modelMatrix(), glm::vec3(0.0f), planet.sun };
+}
+
+// block is the planet's Object block in uniforms
+void queuePlanet(GameObject& planet, RenderPass pass, MeshArena& arena, ShaderProgram& sp,
+		UniformBuffer const& uniforms, size_t block, Assignment4& a4, RenderQueue& queue) {
+	ArenaMesh mesh = planet.mesh->range;
+	Texture& texture = *planet.texture->textures;
+	queue.submit(RenderCommand{
+		RenderQueue::makeKey(pass, sp, texture.getID(), a4.viewDepth(planet.worldCenter())),
+		&sp, &texture, &arena.vertexArray(mesh.format),
+		[&planet, &sp, &uniforms, block, mesh] {
+			uniforms.bind(OBJECT_BLOCK_BINDING, block);
+
+			// not worth inverting the model matrix for a shader that doesn't read it
+			if (sp.hasUniform("Norm")) {
+				sp.setUniform("Norm", glm::mat3(transpose(inverse(planet.modelMatrix()))));
+			}
+			glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, mesh.indices(), mesh.baseVertex);
+		} });
+}
+
+// Bodies that share a mesh and a texture binding, drawn with one call. Bodies in
+// the same texture array share a group, their layers and sun flags are per instance.
+struct InstanceGroup {
+	std::shared_ptr<GameMesh> mesh;
+	std::shared_ptr<Texture> texture;
+	std::vector<GameObject*> bodies;
+};
+
+// Adds the planet drawn with mesh, which can be a detail level of planet.mesh
+void addInstance(std::vector<InstanceGroup>& groups, GameObject& planet, std::shared_ptr<GameMesh> const& mesh) {
+	for (InstanceGroup& group : groups) {
+		if (group.mesh == mesh && group.texture == planet.texture->textures) {
+			group.bodies.push_back(&planet);
+			return;
+		}
+	}
+	groups.push_back(InstanceGroup{ mesh, planet.texture->textures, { &planet } });
+}
+
+// The per-instance data of every body in group, see InstanceBuffer
+void appendInstances(InstanceGroup const& group, std::vector<glm::mat4>& matrices, std::vector<glm::vec2>& materials) {
+	for (GameObject* planet : group.bodies) {
+		matrices.push_back(planet->modelMatrix());
+		materials.push_back(glm::vec2(float(planet->texture->layer), planet->sun));
+	}
+}
+
+// Nearest body of the group, for the depth part of its sort key
+float groupDepth(InstanceGroup const& group, Assignment4& a4) {
+	float depth = 1.0f;
+	for (GameObject* planet : group.bodies) {
+		depth = std::min(depth, a4.viewDepth(planet->worldCenter()));
+	}
+	return depth;
+}
+
+// Uploads the instance matrices of every group, adds a draw command per group
+// and queues one multi-draw for each run of groups sharing a VAO and texture
+void queueInstanced(std::vector<InstanceGroup>& groups, MeshArena& arena, ShaderProgram& sp, Assignment4& a4,
+		DrawCommandBuffer& commands, RenderQueue& queue) {
+	std::vector<glm::mat4> matrices;
+	std::vector<glm::vec2> materials;
+
+	// keep groups of the same vertex format next to each other so they share one VAO and upload,
+	// and within that the same texture so they share one draw
+	std::stable_sort(groups.begin(), groups.end(), [](InstanceGroup const& a, InstanceGroup const& b) {
+		if (a.mesh->range.format != b.mesh->range.format) {
+			return a.mesh->range.format < b.mesh->range.format;
+		}
+		return a.texture->getID() < b.texture->getID();
+	});
+
+	size_t first = 0;
+	while (first < groups.size()) {
+		// all groups with meshes in this format
+		VertexFormat format = groups[first].mesh->range.format;
+		size_t last = first;
+		matrices.clear();
+		materials.clear();
+		while (last < groups.size() && groups[last].mesh->range.format == format) {
+			appendInstances(groups[last], matrices, materials);
+			last++;
+		}
+
+		InstanceBuffer& instances = arena.instances(format);
+		instances.uploadData(matrices, materials);
+		const VertexArray& vao = arena.vertexArray(format);
+
+		GLuint firstInstance = 0;
+		size_t i = first;
+		while (i < last) {
+			// all groups in this format with this texture
+			Texture& texture = *groups[i].texture;
+			size_t firstCommand = commands.size();
+			float depth = 1.0f;
+			for (; i < last && groups[i].texture.get() == &texture; i++) {
+				GLuint count = GLuint(groups[i].bodies.size());
+				commands.add(groups[i].mesh->range, count, firstInstance);
+				depth = std::min(depth, groupDepth(groups[i], a4));
+				firstInstance += count;
+			}
+			size_t commandCount = commands.size() - firstCommand;
+
+			queue.submit(RenderCommand{
+				RenderQueue::makeKey(RenderPass::Opaque, sp, texture.getID(), depth),
+				&sp, &texture, &vao,
+				[&commands, &instances, firstCommand, commandCount] {
+					commands.draw(firstCommand, commandCount, instances);
+				} });
+		}
+		first = last;
+	}
+}
+
+// Same draws as queueInstanced, but every instance is uploaded and the GPU leaves
+// out the ones outside the frustum, see InstanceCuller. The culling runs right
+// away, the draws read how many instances survived when the queue is flushed.
+void queueGpuCulled(std::vector<InstanceGroup> const& groups, MeshArena& arena, InstanceCuller& culler,
+		ShaderProgram& sp, Assignment4& a4, RenderQueue& queue) {
+	std::vector<glm::mat4> matrices;
+	std::vector<glm::vec2> materials;
+	for (InstanceGroup const& group : groups) {
+		appendInstances(group, matrices, materials);
+	}
+	culler.uploadData(matrices, materials);
+
+	GLuint firstInstance = 0;
+	for (InstanceGroup const& group : groups) {
+		ArenaMesh mesh = group.mesh->range;
+		Texture& texture = *group.texture;
+		GLuint count = GLuint(group.bodies.size());
+		size_t batch = culler.cull(firstInstance, count, group.mesh->boundingRadius);
+		firstInstance += count;
+
+		InstanceBuffer& instances = arena.instances(mesh.format);
+		queue.submit(RenderCommand{
+			RenderQueue::makeKey(RenderPass::Opaque, sp, texture.getID(), groupDepth(group, a4)),
+			&sp, &texture, &arena.vertexArray(mesh.format),
+			[&culler, &instances, batch, mesh] {
+				GLuint visible = culler.visibleCount(batch);
+				if (visible == 0) {
+					return;
+				}
+				culler.bindOutput(batch, instances);
+				glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, mesh.indices(),
+					GLsizei(visible), mesh.baseVertex);
+			} });
+	}
+}
+
+// A ring to draw this frame and how many segments it needs to look round
+struct RingInstance {
+	GameObject* planet;
+	GLint segments;
+	size_t block = 0; // its Ring block in the frame's UniformBuffer
+};
+
+// Queues the Ring block of every ring for this frame's upload
+void addRingBlocks(std::vector<RingInstance>& rings, UniformBuffer& uniforms) {
+	for (RingInstance& instance : rings) {
+		PlanetRing const& ring = *instance.planet->ring;
+		instance.block = uniforms.add(RingBlock{ instance.planet->ringMatrix(), ring.innerRadius, ring.outerRadius, instance.segments });
+	}
+}
+
+// noAttributes is bound for the draws since the core profile still wants a VAO
+void queueRings(std::vector<RingInstance> const& rings, VertexArray const& noAttributes, ShaderProgram& sp,
+		UniformBuffer const& uniforms, Assignment4& a4, RenderQueue& queue) {
+	for (RingInstance const& instance : rings) {
+		Texture& texture = *instance.planet->ring->texture->textures;
+		size_t block = instance.block;
+		GLint segments = instance.segments;
+		queue.submit(RenderCommand{
+			RenderQueue::makeKey(RenderPass::Opaque, sp, texture.getID(), a4.viewDepth(instance.planet->worldCenter())),
+			&sp, &texture, &noAttributes,
+			[&uniforms, block, segments] {
+				uniforms.bind(OBJECT_BLOCK_BINDING, block);
+				glDrawArrays(GL_TRIANGLE_STRIP, 0, 2 * (segments + 1));
+			} });
+	}
+}
+
+// One step of the sphere LOD chain, used while the body covers more than minPixels.
+// slices is the tessellation of the same step when spheres are drawn procedurally.
+struct SphereLod {
+	float minPixels;
+	std::shared_ptr<GameMesh> mesh;
+	GLint slices;
+};
+
+// What spheres are drawn with when they have no vertex data at all: shaders/sphere.vert
+// makes a UV sphere from gl_VertexID, only the instance matrices are stored.
+// note: the VAO binds itself when constructed, which is
+// where the instance buffer then sets up its attributes
+struct ProceduralSpheres {
+	VertexArray vao;
+	InstanceBuffer instances{ 3 };
+};
+
+// Queues the groups that use a sphere LOD to be drawn procedurally and takes them
+// out of groups, whatever is left still needs its mesh
+void queueProcedural(std::vector<InstanceGroup>& groups, std::vector<SphereLod> const& sphereLods,
+		ProceduralSpheres& spheres, ShaderProgram& sp, Assignment4& a4, RenderQueue& queue) {
+	auto slicesOf = [&sphereLods](InstanceGroup const& group) {
+		auto lod = std::find_if(sphereLods.begin(), sphereLods.end(), [&group](SphereLod const& l) {
+			return l.mesh == group.mesh;
+		});
+		return lod != sphereLods.end() ? lod->slices : 0;
+	};
+	auto end = std::stable_partition(groups.begin(), groups.end(), [&slicesOf](InstanceGroup const& group) {
+		return slicesOf(group) > 0;
+	});
+
+	std::vector<glm::mat4> matrices;
+	std::vector<glm::vec2> materials;
+	for (auto group = groups.begin(); group != end; ++group) {
+		appendInstances(*group, matrices, materials);
+	}
+	if (!matrices.empty()) {
+		spheres.instances.uploadData(matrices, materials);
+	}
+
+	GLuint firstInstance = 0;
+	for (auto group = groups.begin(); group != end; ++group) {
+		GLint slices = slicesOf(*group);
+		Texture& texture = *group->texture;
+		GLsizei count = GLsizei(group->bodies.size());
+		InstanceBuffer& instances = spheres.instances;
+		queue.submit(RenderCommand{
+			RenderQueue::makeKey(RenderPass::Opaque, sp, texture.getID(), groupDepth(*group, a4)),
+			&sp, &texture, &spheres.vao,
+			[&sp, &instances, firstInstance, slices, count] {
+				instances.setFirstInstance(firstInstance);
+				sp.setUniform("slices", int(slices));
+				// slices around by slices / 2 from pole to pole, two triangles each
+				glDrawArraysInstanced(GL_TRIANGLES, 0, 6 * slices * (slices / 2), count);
+			} });
+		firstInstance += GLuint(count);
+	}
+
+	groups.erase(groups.begin(), end);
+}
+
+// A sphere body big enough for a mesh while occlusion culling is on. Every one of
+// them gets a proxy query, the hidden ones are drawn on their own, see queueOcclusion.
+struct Occludee {
+	size_t id; // index in the bodies
+	GameObject* planet;
+	std::shared_ptr<GameMesh> mesh; // the detail level it would be drawn with
+	GLint slices;                   // the same level drawn procedurally
+	bool hidden; // by its last query, so it isn't in any instance group
+};
+
+// Queues the proxy query of every occludee after the opaque draws, then the
+// hidden ones on their own, which the GPU only draws if their proxy passed. They
+// are drawn the way the visible bodies are, from their arena mesh with meshShader,
+// or as procedural spheres with sphereShader if those are on, so they don't
+// change shape when they come out from behind something.
+// spheres holds the hidden bodies' instances whichever way they are drawn.
+void queueOcclusion(std::vector<Occludee> const& occludees, OcclusionQueries& occlusion, MeshArena& arena,
+		ProceduralSpheres& spheres, bool procedural, ShaderProgram& meshShader, ShaderProgram& sphereShader,
+		Assignment4& a4, RenderQueue& queue) {
+	if (occludees.empty()) {
+		return;
+	}
+	glm::vec3 eye = a4.camera.getPos();
+	ShaderProgram& proxy = occlusion.program();
+	queue.submit(RenderCommand{
+		RenderQueue::makeKey(RenderPass::Occlusion, proxy, 0, 0.0f),
+		&proxy, nullptr, &occlusion.vertexArray(),
+		[&occludees, &occlusion, eye] {
+			// the proxies are only tested, never seen
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			glDepthMask(GL_FALSE);
+			for (Occludee const& occludee : occludees) {
+				occlusion.query(occludee.id, occludee.planet->bounds(), eye);
+			}
+			glDepthMask(GL_TRUE);
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		} });
+
+	std::vector<glm::mat4> matrices;
+	std::vector<glm::vec2> materials;
+	for (Occludee const& occludee : occludees) {
+		if (occludee.hidden) {
+			matrices.push_back(occludee.planet->modelMatrix());
+			materials.push_back(glm::vec2(float(occludee.planet->texture->layer), occludee.planet->sun));
+		}
+	}
+	if (matrices.empty()) {
+		return;
+	}
+	spheres.instances.uploadData(matrices, materials);
+
+	GLuint instance = 0;
+	for (Occludee const& occludee : occludees) {
+		if (!occludee.hidden) {
+			continue;
+		}
+		Texture& texture = *occludee.planet->texture->textures;
+		float depth = a4.viewDepth(occludee.planet->worldCenter());
+		InstanceBuffer& hidden = spheres.instances;
+
+		if (procedural) {
+			queue.submit(RenderCommand{
+				RenderQueue::makeKey(RenderPass::Conditional, sphereShader, texture.getID(), depth),
+				&sphereShader, &texture, &spheres.vao,
+				[&sphereShader, &hidden, &occlusion, occludee, instance] {
+					occlusion.drawConditional(occludee.id, [&] {
+						hidden.setFirstInstance(instance);
+						sphereShader.setUniform("slices", int(occludee.slices));
+						glDrawArraysInstanced(GL_TRIANGLES, 0, 6 * occludee.slices * (occludee.slices / 2), 1);
+					});
+				} });
+		}
+		else {
+			ArenaMesh mesh = occludee.mesh->range;
+			InstanceBuffer& instances = arena.instances(mesh.format);
+			queue.submit(RenderCommand{
+				RenderQueue::makeKey(RenderPass::Conditional, meshShader, texture.getID(), depth),
+				&meshShader, &texture, &arena.vertexArray(mesh.format),
+				[&instances, &hidden, &occlusion, occludee, mesh, instance] {
+					occlusion.drawConditional(occludee.id, [&] {
+						instances.readFrom(hidden, instance);
+						glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, mesh.indices(),
+							1, mesh.baseVertex);
+					});
+				} });
+		}
+		instance++;
 	}
 }
 
-void resetScene(GameObject& sun, GameObject& earth, GameObject& moon, GameObject& mercury, GameObject& venus, GameObject& mars, GameObject& marsMoon1, GameObject& marsMoon2, GameObject& jupiter, GameObject& jupiterMoon1, GameObject& jupiterMoon2, GameObject& jupiterMoon3, GameObject& saturn, GameObject& saturnRings, GameObject& saturnMoon1, GameObject& saturnMoon2, GameObject& saturnMoon3, GameObject& uranus, GameObject& uranusMoon1, GameObject& uranusMoon2, GameObject& uranusMoon3, GameObject& neptune, GameObject& neptuneMoon1, GameObject& neptuneMoon2, GameObject& neptuneMoon3) {
-	sun.transformationMatrix = glm::mat4(1.0f);
-	earth.transformationMatrix = glm::mat4(1.0f);
-	moon.transformationMatrix = glm::mat4(1.0f);
-	mercury.transformationMatrix = glm::mat4(1.0f);
-	venus.transformationMatrix = glm::mat4(1.0f);
-	mars.transformationMatrix = glm::mat4(1.0f);
-	marsMoon1.transformationMatrix = glm::mat4(1.0f);
-	marsMoon2.transformationMatrix = glm::mat4(1.0f);
-	jupiter.transformationMatrix = glm::mat4(1.0f);
-	jupiterMoon1.transformationMatrix = glm::mat4(1.0f);
-	jupiterMoon2.transformationMatrix = glm::mat4(1.0f);
-	jupiterMoon3.transformationMatrix = glm::mat4(1.0f);
-	saturn.transformationMatrix = glm::mat4(1.0f);
-	saturnRings.transformationMatrix = glm::mat4(1.0f);
-	saturnMoon1.transformationMatrix = glm::mat4(1.0f);
-	saturnMoon2.transformationMatrix = glm::mat4(1.0f);
-	saturnMoon3.transformationMatrix = glm::mat4(1.0f);
-	uranus.transformationMatrix = glm::mat4(1.0f);
-	uranusMoon1.transformationMatrix = glm::mat4(1.0f);
-	uranusMoon2.transformationMatrix = glm::mat4(1.0f);
-	uranusMoon3.transformationMatrix = glm::mat4(1.0f);
-	neptune.transformationMatrix = glm::mat4(1.0f);
-	neptuneMoon1.transformationMatrix = glm::mat4(1.0f);
-	neptuneMoon2.transformationMatrix = glm::mat4(1.0f);
-	neptuneMoon3.transformationMatrix = glm::mat4(1.0f);
-
-	sun.cgeom = sphereGeometry(sun.radius, sun.center);
-	earth.cgeom = sphereGeometry(earth.radius, earth.center);
-	moon.cgeom = sphereGeometry(moon.radius, moon.center);
-	mercury.cgeom = sphereGeometry(mercury.radius, mercury.center);
-	venus.cgeom = sphereGeometry(venus.radius, venus.center);
-	mars.cgeom = sphereGeometry(mars.radius, mars.center);
-	marsMoon1.cgeom = sphereGeometry(marsMoon1.radius, marsMoon1.center);
-	marsMoon2.cgeom = sphereGeometry(marsMoon2.radius, marsMoon2.center);
-	jupiter.cgeom = sphereGeometry(jupiter.radius, jupiter.center);
-	jupiterMoon1.cgeom = sphereGeometry(jupiterMoon1.radius, jupiterMoon1.center);
-	jupiterMoon2.cgeom = sphereGeometry(jupiterMoon2.radius, jupiterMoon2.center);
-	jupiterMoon3.cgeom = sphereGeometry(jupiterMoon3.radius, jupiterMoon3.center);
-	saturn.cgeom = sphereGeometry(saturn.radius, saturn.center);
-	saturnRings.cgeom = saturnsRings(saturnRings.radius, saturnRings.center);
-	saturnMoon1.cgeom = sphereGeometry(saturnMoon1.radius, saturnMoon1.center);
-	saturnMoon2.cgeom = sphereGeometry(saturnMoon2.radius, saturnMoon2.center);
-	saturnMoon3.cgeom = sphereGeometry(saturnMoon3.radius, saturnMoon3.center);
-	uranus.cgeom = sphereGeometry(uranus.radius, uranus.center);
-	uranusMoon1.cgeom = sphereGeometry(uranusMoon1.radius, uranusMoon1.center);
-	uranusMoon2.cgeom = sphereGeometry(uranusMoon2.radius, uranusMoon2.center);
-	uranusMoon3.cgeom = sphereGeometry(uranusMoon3.radius, uranusMoon3.center);
-	neptune.cgeom = sphereGeometry(neptune.radius, neptune.center);
-	neptuneMoon1.cgeom = sphereGeometry(neptuneMoon1.radius, neptuneMoon1.center);
-	neptuneMoon2.cgeom = sphereGeometry(neptuneMoon2.radius, neptuneMoon2.center);
-	neptuneMoon3.cgeom = sphereGeometry(neptuneMoon3.radius, neptuneMoon3.center);
-	tiltAxis(earth);
-	tiltAxis(moon);
-	tiltAxis(mercury);
-	tiltAxis(venus);
-	tiltAxis(mars);
-	tiltAxis(marsMoon1);
-	tiltAxis(marsMoon2);
-	tiltAxis(jupiter);
-	tiltAxis(jupiterMoon1);
-	tiltAxis(jupiterMoon2);
-	tiltAxis(jupiterMoon3);
-	tiltAxis(saturn);
-	tiltAxis(saturnMoon1);
-	tiltAxis(saturnMoon2);
-	tiltAxis(saturnMoon3);
-	tiltAxis(uranus);
-	tiltAxis(uranusMoon1);
-	tiltAxis(uranusMoon2);
-	tiltAxis(uranusMoon3);
-	tiltAxis(neptune);
-	tiltAxis(neptuneMoon1);
-	tiltAxis(neptuneMoon2);
-	tiltAxis(neptuneMoon3);
-
-	updateGPUGeometry(sun.ggeom, sun.cgeom);
-	updateGPUGeometry(earth.ggeom, earth.cgeom);
-	updateGPUGeometry(mercury.ggeom, mercury.cgeom);
-	updateGPUGeometry(venus.ggeom, venus.cgeom);
-	updateGPUGeometry(mars.ggeom, mars.cgeom);
-	updateGPUGeometry(marsMoon1.ggeom, marsMoon1.cgeom);
-	updateGPUGeometry(marsMoon2.ggeom, marsMoon2.cgeom);
-	updateGPUGeometry(jupiter.ggeom, jupiter.cgeom);
-	updateGPUGeometry(jupiterMoon1.ggeom, jupiterMoon1.cgeom);
-	updateGPUGeometry(jupiterMoon2.ggeom, jupiterMoon2.cgeom);
-	updateGPUGeometry(jupiterMoon3.ggeom, jupiterMoon3.cgeom);
-	updateGPUGeometry(saturn.ggeom, saturn.cgeom);
-	updateGPUGeometry(saturnRings.ggeom, saturnRings.cgeom);
-	updateGPUGeometry(saturnMoon1.ggeom, saturnMoon1.cgeom);
-	updateGPUGeometry(saturnMoon2.ggeom, saturnMoon2.cgeom);
-	updateGPUGeometry(saturnMoon3.ggeom, saturnMoon3.cgeom);
-	updateGPUGeometry(uranus.ggeom, uranus.cgeom);
-	updateGPUGeometry(uranusMoon1.ggeom, uranusMoon1.cgeom);
-	updateGPUGeometry(uranusMoon2.ggeom, uranusMoon2.cgeom);
-	updateGPUGeometry(uranusMoon3.ggeom, uranusMoon3.cgeom);
-	updateGPUGeometry(neptune.ggeom, neptune.cgeom);
-	updateGPUGeometry(neptuneMoon1.ggeom, neptuneMoon1.cgeom);
-	updateGPUGeometry(neptuneMoon2.ggeom, neptuneMoon2.cgeom);
-	updateGPUGeometry(neptuneMoon3.ggeom, neptuneMoon3.cgeom);
+// Drawables tested against the view frustum in a frame and how many of them were left out
+struct CullStats {
+	size_t tested = 0;
+	size_t culled = 0;
+
+	bool operator==(CullStats const& other) const {
+		return tested == other.tested && culled == other.culled;
+	}
+	bool operator!=(CullStats const& other) const { return !(*this == other); }
+};
+
+// True if sphere can be on screen, counted in stats
+bool isVisible(Frustum const& frustum, BoundingSphere const& sphere, CullStats& stats) {
+	stats.tested++;
+	if (frustum.intersects(sphere)) {
+		return true;
+	}
+	stats.culled++;
+	return false;
 }
 
-void drawPlanet(GameObject& planet, ShaderProgram& sp) {
-	GLint uniMat = glGetUniformLocation(sp, "M");
-	GLint centerloc = glGetUniformLocation(sp, "center");
-	GLint normalLoc = glGetUniformLocation(sp, "Norm");
+// Sorts every body into the instance group of the mesh detail it needs this frame.
+// Bodies and rings outside the frustum are left out before anything else is done
+// with them, unless cullBodies is off because the GPU culls the bodies instead.
+// Spheres smaller than the coarsest level become point sprites and rings too small
+// to see are left out, the others get segments for their size on screen.
+// With occlusion (can be null) the spheres also become occludees, and the ones
+// their last query found hidden are kept out of the groups.
+void selectLods(std::vector<GameObject*> const& bodies, std::vector<SphereLod> const& sphereLods, Assignment4& a4,
+		Frustum const& frustum, bool cullBodies, std::vector<InstanceGroup>& groups, CPU_PointSprites& sprites,
+		std::vector<RingInstance>& rings, CullStats& stats,
+		OcclusionQueries const* occlusion, std::vector<Occludee>& occludees) {
+	groups.clear();
+	sprites.clear();
+	rings.clear();
+	occludees.clear();
+
+	for (size_t id = 0; id < bodies.size(); id++) {
+		GameObject* planet = bodies[id];
+		glm::vec3 center = planet->worldCenter();
+
+		// the ring reaches further than the body, so it is tested on its own
+		if (planet->ring && isVisible(frustum, BoundingSphere{ center, planet->ring->outerRadius }, stats)) {
+			float ringPixels = a4.projectedRadius(center, planet->ring->outerRadius);
+			if (ringPixels > sphereLods.back().minPixels) {
+				GLint segments = std::clamp(GLint(ringPixels), RING_MIN_SEGMENTS, RING_MAX_SEGMENTS);
+				rings.push_back(RingInstance{ planet, segments });
+			}
+		}
+
+		if (cullBodies && !isVisible(frustum, planet->bounds(), stats)) {
+			continue;
+		}
 
-	glUniformMatrix4fv(uniMat, 1, GL_FALSE, glm::value_ptr(planet.transformationMatrix));
-	glUniform3fv(centerloc, 1, glm::value_ptr(planet.center));
+		float pixels = a4.projectedRadius(center, planet->worldRadius());
 
-	glm::mat3 normal = transpose(inverse(planet.transformationMatrix));
-	glUniformMatrix3fv(normalLoc, 1, GL_FALSE, glm::value_ptr(normal));
+		if (planet->mesh != sphereLods.front().mesh) {
+			if (pixels > sphereLods.back().minPixels) {
+				addInstance(groups, *planet, planet->mesh);
+			}
+			continue;
+		}
 
-	planet.ggeom.bind();
-	planet.texture->textures.bind();
-	glDrawArrays(GL_TRIANGLES, 0, GLsizei(planet.cgeom.verts.size()));
-	planet.texture->textures.unbind();
+		auto lod = std::find_if(sphereLods.begin(), sphereLods.end(), [pixels](SphereLod const& l) {
+			return pixels > l.minPixels;
+		});
+		if (lod != sphereLods.end() && occlusion != nullptr) {
+			bool hidden = !occlusion->wasVisible(id);
+			occludees.push_back(Occludee{ id, planet, lod->mesh, lod->slices, hidden });
+			if (!hidden) {
+				addInstance(groups, *planet, lod->mesh);
+			}
+		}
+		else if (lod != sphereLods.end()) {
+			addInstance(groups, *planet, lod->mesh);
+		}
+		else {
+			sprites.verts.push_back(center);
+			sprites.colors.push_back(planet->texture->averageColor());
+			sprites.sizes.push_back(std::max(2.0f * pixels, 1.0f));
+		}
+	}
+}
+
+// Mesh that is either mapped from the cache or still being generated
+struct PendingMesh {
+	MeshKey key;
+	std::optional<CachedMesh> cached;
+	size_t ticket = 0;
+};
+
+// Queues generate on the builder unless the cache already has the mesh for key.
+// Generated meshes are optimized and written to the cache by the worker that made them.
+PendingMesh requestMesh(MeshCache const& cache, GeometryBuilder& builder, MeshKey key, GeometryBuilder::Generator generate) {
+	PendingMesh pending{ key, cache.load(key) };
+	if (!pending.cached) {
+		pending.ticket = builder.add([&cache, key, generate] {
+			CPU_Geometry geom = generate();
+			MeshOptimizationReport report = optimizeMesh(geom);
+			Log::info("MESH {} vertex cache ACMR {:.3f} -> {:.3f}", key.generator, report.acmrBefore, report.acmrAfter);
+			cache.store(key, geom);
+			return geom;
+		});
+	}
+	return pending;
+}
+
+// Copies a requested mesh into the arena, waiting for the builder if it had to be generated
+std::shared_ptr<GameMesh> finishMesh(MeshArena& arena, GeometryBuilder& builder, PendingMesh& pending) {
+	if (pending.cached) {
+		std::shared_ptr<GameMesh> mesh = std::make_shared<GameMesh>(arena, *pending.cached, pending.key.format);
+		pending.cached.reset(); // done with the mapping
+		return mesh;
+	}
+	return std::make_shared<GameMesh>(arena, builder.take(pending.ticket), pending.key.format);
 }
 
 int main() {
@@ -395,267 +806,243 @@ int main() {
 	auto a4 = std::make_shared<Assignment4>();
 	window.setCallbacks(a4);
 
+	// MESHES
+	// mapped from the cache when nothing changed since the last run, otherwise
+	// generated on worker threads while the textures load. Uploaded further down.
+	const glm::vec3 origin{ 0.0f, 0.0f, 0.0f };
+	MeshCache meshCache("cache");
+	GeometryBuilder meshBuilder;
+	std::vector<PendingMesh> pendingSpheres;
+	for (int subdivisions : { 4, 3, 2, 1 }) {
+		pendingSpheres.push_back(requestMesh(meshCache, meshBuilder,
+			{ "icosphere", { 1.0f, origin.x, origin.y, origin.z, float(subdivisions) }, VertexFormat::PackedUnitSphere },
+			[=] { return icosphereGeometry(1.0f, origin, subdivisions); }));
+	}
+	PendingMesh pendingSky = requestMesh(meshCache, meshBuilder,
+		{ "cubesphere", { 1.0f, origin.x, origin.y, origin.z, 16.0f }, VertexFormat::PackedUnitSphere },
+		[=] { return cubeSphereGeometry(1.0f, origin, 16); });
+	meshBuilder.start();
+
 	ShaderProgram shader("shaders/test.vert", "shaders/test.frag");
+	ShaderProgram instancedShader("shaders/instanced.vert", "shaders/array.frag");
+	ShaderProgram ringShader("shaders/ring.vert", "shaders/test.frag");
+	ShaderProgram sphereShader("shaders/sphere.vert", "shaders/array.frag");
 
 	UnitCube cube;
 	cube.generateGeometry();
 
-	std::shared_ptr<GameTexture> sunTexture = std::make_shared<GameTexture>(
-		"textures/sun.jpg",
-		GL_NEAREST
-		);
-	std::shared_ptr<GameTexture> earthTexture = std::make_shared<GameTexture>(
-		"textures/earth.jpg",
-		GL_NEAREST
-		);
-	std::shared_ptr<GameTexture> moonTexture = std::make_shared<GameTexture>(
-		"textures/moon.jpg",
-		GL_NEAREST
+	// every body texture is a layer of one array, so bodies with different
+	// textures can still share an instanced draw
+	std::shared_ptr<Texture> bodyTextures = std::make_shared<Texture>(
+		std::vector<std::string>{
+			"textures/sun.jpg",
+			"textures/earth.jpg",
+			"textures/moon.jpg",
+			"textures/mercury.jpg",
+			"textures/venus.jpg",
+			"textures/mars.jpg",
+			"textures/jupiter.jpg",
+			"textures/saturn.jpg",
+			"textures/uranus.jpg",
+			"textures/neptune.jpg",
+		},
+		GL_NEAREST,
+		glm::ivec2(2048, 1024)
 		);
+	std::shared_ptr<GameTexture> sunTexture = std::make_shared<GameTexture>(bodyTextures, 0);
+	std::shared_ptr<GameTexture> earthTexture = std::make_shared<GameTexture>(bodyTextures, 1);
+	std::shared_ptr<GameTexture> moonTexture = std::make_shared<GameTexture>(bodyTextures, 2);
+	std::shared_ptr<GameTexture> mercuryTexture = std::make_shared<GameTexture>(bodyTextures, 3);
+	std::shared_ptr<GameTexture> venusTexture = std::make_shared<GameTexture>(bodyTextures, 4);
+	std::shared_ptr<GameTexture> marsTexture = std::make_shared<GameTexture>(bodyTextures, 5);
+	std::shared_ptr<GameTexture> jupiterTexture = std::make_shared<GameTexture>(bodyTextures, 6);
+	std::shared_ptr<GameTexture> saturnTexture = std::make_shared<GameTexture>(bodyTextures, 7);
+	std::shared_ptr<GameTexture> uranusTexture = std::make_shared<GameTexture>(bodyTextures, 8);
+	std::shared_ptr<GameTexture> neptuneTexture = std::make_shared<GameTexture>(bodyTextures, 9);
 	std::shared_ptr<GameTexture> spaceTexture = std::make_shared<GameTexture>(
 		"textures/space.jpg",
 		GL_NEAREST
 		);
-	std::shared_ptr<GameTexture> mercuryTexture = std::make_shared<GameTexture>(
-		"textures/mercury.jpg",
-		GL_NEAREST
-		);
-	std::shared_ptr<GameTexture> venusTexture = std::make_shared<GameTexture>(
-		"textures/venus.jpg",
-		GL_NEAREST
-		);
-	std::shared_ptr<GameTexture> marsTexture = std::make_shared<GameTexture>(
-		"textures/mars.jpg",
-		GL_NEAREST
-		);
-	std::shared_ptr<GameTexture> jupiterTexture = std::make_shared<GameTexture>(
-		"textures/jupiter.jpg",
-		GL_NEAREST
-		);
-	std::shared_ptr<GameTexture> saturnTexture = std::make_shared<GameTexture>(
-		"textures/saturn.jpg",
-		GL_NEAREST
-		);
-	std::shared_ptr<GameTexture> uranusTexture = std::make_shared<GameTexture>(
-		"textures/uranus.jpg",
-		GL_NEAREST
-		);
-	std::shared_ptr<GameTexture> neptuneTexture = std::make_shared<GameTexture>(
-		"textures/neptune.jpg",
-		GL_NEAREST
-		);
 	std::shared_ptr<GameTexture> saturnRingsTexture = std::make_shared<GameTexture>(
 		"textures/saturnRings.png",
 		GL_NEAREST
 		);
 
-	GameObject sun(sunTexture, glm::vec3{ 0.0f, 0.0f, 0.0f }, 0.8f, 0.0f, 0.0f);
-	tiltAxis(sun);
-	updateGPUGeometry(sun.ggeom, sun.cgeom);
+
+	// every static mesh lives in this one vertex and index buffer
+	MeshArena meshArena(1 << 20, 1 << 20);
+
+	// every body draws the same unit sphere, its positions are its normals
+	std::shared_ptr<GameMesh> sphereMesh = finishMesh(meshArena, meshBuilder, pendingSpheres[0]);
+
+	// coarser spheres for bodies that are small on screen, thresholds are radii in pixels.
+	// The slices give about as many triangles as the icosphere of the same step.
+	std::vector<SphereLod> sphereLods = {
+		{ 100.0f, sphereMesh, 64 },
+		{ 30.0f, finishMesh(meshArena, meshBuilder, pendingSpheres[1]), 32 },
+		{ 8.0f, finishMesh(meshArena, meshBuilder, pendingSpheres[2]), 16 },
+		{ 1.5f, finishMesh(meshArena, meshBuilder, pendingSpheres[3]), 8 },
+	};
+
+	GameObject sun(sunTexture, sphereMesh, glm::vec3{ 0.0f, 0.0f, 0.0f }, 0.8f, 0.0f, 0.0f);
+	sun.sun = 1.0f;
 
 	//Earth
 	float distanceFromParent = 2.0f;
 	float orbitAngle = 20.0f;
 	float tiltAngle = 23.4f;
-	GameObject earth(earthTexture, (sun.center + glm::vec3{ distanceFromParent*cos(glm::radians(orbitAngle)), distanceFromParent*sin(glm::radians(orbitAngle)), 0.0f}), 0.08f, tiltAngle, orbitAngle);
-	tiltAxis(earth);
-	updateGPUGeometry(earth.ggeom, earth.cgeom);
+	GameObject earth(earthTexture, sphereMesh, (sun.center + glm::vec3{ distanceFromParent*cos(glm::radians(orbitAngle)), distanceFromParent*sin(glm::radians(orbitAngle)), 0.0f}), 0.08f, tiltAngle, orbitAngle);
 
 	//Earth moon
 	distanceFromParent = 0.2f;
 	float orbitAngle2 = 10.0f; //from earth orbit angle
 	tiltAngle = 10.0f;
-	GameObject moon(moonTexture,(earth.center + glm::vec3{ distanceFromParent *cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent *sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.02f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(moon);
-	updateGPUGeometry(moon.ggeom, moon.cgeom);
+	GameObject moon(moonTexture, sphereMesh, (earth.center + glm::vec3{ distanceFromParent *cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent *sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.02f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Mercury
 	distanceFromParent = 1.2f;
 	orbitAngle = 17.0f;
 	tiltAngle = 0.04f;
-	GameObject mercury(mercuryTexture, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.027f, tiltAngle, orbitAngle);
-	tiltAxis(mercury);
-	updateGPUGeometry(mercury.ggeom, mercury.cgeom);
+	GameObject mercury(mercuryTexture, sphereMesh, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.027f, tiltAngle, orbitAngle);
 
 	//Venus
 	distanceFromParent = 1.6f;
 	orbitAngle = 13.4f;
 	tiltAngle = 177.4f;
-	GameObject venus(venusTexture, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.075f, tiltAngle, orbitAngle);
-	tiltAxis(venus);
-	updateGPUGeometry(venus.ggeom, venus.cgeom);
+	GameObject venus(venusTexture, sphereMesh, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.075f, tiltAngle, orbitAngle);
 
 	//Mars
 	distanceFromParent = 3.4f;
 	orbitAngle = 11.8f;
 	tiltAngle = 25.2f;
-	GameObject mars(marsTexture, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.05f, tiltAngle, orbitAngle);
-	tiltAxis(mars);
-	updateGPUGeometry(mars.ggeom, mars.cgeom);
+	GameObject mars(marsTexture, sphereMesh, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.05f, tiltAngle, orbitAngle);
 
 	//Mars moon1
 	distanceFromParent = 0.2f;
 	orbitAngle2 = 10.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject marsMoon1(moonTexture, (mars.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.025f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(marsMoon1);
-	updateGPUGeometry(marsMoon1.ggeom, marsMoon1.cgeom);
+	GameObject marsMoon1(moonTexture, sphereMesh, (mars.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.025f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Mars moon2
 	distanceFromParent = 0.25f;
 	orbitAngle2 = 60.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject marsMoon2(moonTexture, (mars.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.02f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(marsMoon2);
-	updateGPUGeometry(marsMoon2.ggeom, marsMoon2.cgeom);
+	GameObject marsMoon2(moonTexture, sphereMesh, (mars.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.02f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Jupiter
 	distanceFromParent = 8.0f;
 	orbitAngle = 11.3f;
 	tiltAngle = 3.1f;
-	GameObject jupiter(jupiterTexture, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.48f, tiltAngle, orbitAngle);
-	tiltAxis(jupiter);
-	updateGPUGeometry(jupiter.ggeom, jupiter.cgeom);
+	GameObject jupiter(jupiterTexture, sphereMesh, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.48f, tiltAngle, orbitAngle);
 
 	//Jupiter moon1
 	distanceFromParent = 0.9f;
 	orbitAngle2 = 10.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject jupiterMoon1(moonTexture, (jupiter.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.06f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(jupiterMoon1);
-	updateGPUGeometry(jupiterMoon1.ggeom, jupiterMoon1.cgeom);
+	GameObject jupiterMoon1(moonTexture, sphereMesh, (jupiter.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.06f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Jupiter moon2
 	distanceFromParent = 1.2f;
 	orbitAngle2 = 60.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject jupiterMoon2(moonTexture, (jupiter.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.08f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(jupiterMoon2);
-	updateGPUGeometry(jupiterMoon2.ggeom, jupiterMoon2.cgeom);
+	GameObject jupiterMoon2(moonTexture, sphereMesh, (jupiter.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.08f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Jupiter moon3
 	distanceFromParent = 1.4f;
 	orbitAngle2 = 110.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject jupiterMoon3(moonTexture, (jupiter.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.1f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(jupiterMoon3);
-	updateGPUGeometry(jupiterMoon3.ggeom, jupiterMoon3.cgeom);
+	GameObject jupiterMoon3(moonTexture, sphereMesh, (jupiter.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.1f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Saturn
 	distanceFromParent = 16.0f;
 	orbitAngle = 15.0f;
 	tiltAngle = 26.7f;
-	GameObject saturn(saturnTexture, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.4f, tiltAngle, orbitAngle);
-	tiltAxis(saturn);
-	updateGPUGeometry(saturn.ggeom, saturn.cgeom);
+	GameObject saturn(saturnTexture, sphereMesh, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.4f, tiltAngle, orbitAngle);
 
 	//Saturns Rings
 	distanceFromParent = 0.0f;
 	orbitAngle = 0.0f;
 	tiltAngle = 0.0f;
-	GameObject saturnRings(saturnRingsTexture, (saturn.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.45f, tiltAngle, orbitAngle);
-	saturnRings.cgeom.verts.clear();
-	saturnRings.cgeom.cols.clear();
-	saturnRings.cgeom.normals.clear();
-	saturnRings.cgeom = saturnsRings(saturnRings.radius, saturnRings.center);
-	updateGPUGeometry(saturnRings.ggeom, saturnRings.cgeom);
+	saturn.ring = PlanetRing{ saturnRingsTexture, 0.55f, 1.15f };
 
 	//Saturn moon1
 	distanceFromParent = 0.8f;
 	orbitAngle2 = 10.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject saturnMoon1(moonTexture, (saturn.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.05f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(saturnMoon1);
-	updateGPUGeometry(saturnMoon1.ggeom, saturnMoon1.cgeom);
+	GameObject saturnMoon1(moonTexture, sphereMesh, (saturn.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.05f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Saturn moon2
 	distanceFromParent = 1.0f;
 	orbitAngle2 = 50.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject saturnMoon2(moonTexture, (saturn.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.06f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(saturnMoon2);
-	updateGPUGeometry(saturnMoon2.ggeom, saturnMoon2.cgeom);
+	GameObject saturnMoon2(moonTexture, sphereMesh, (saturn.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.06f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Saturn moon3
 	distanceFromParent = 1.3f;
 	orbitAngle2 = 120.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject saturnMoon3(moonTexture, (saturn.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.07f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(saturnMoon3);
-	updateGPUGeometry(saturnMoon3.ggeom, saturnMoon3.cgeom);
+	GameObject saturnMoon3(moonTexture, sphereMesh, (saturn.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.07f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Uranus
 	distanceFromParent = 32.0f;
 	orbitAngle = 10.8f;
 	tiltAngle = 97.8f;
-	GameObject uranus(uranusTexture, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.17f, tiltAngle, orbitAngle);
-	tiltAxis(uranus);
-	updateGPUGeometry(uranus.ggeom, uranus.cgeom);
+	GameObject uranus(uranusTexture, sphereMesh, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.17f, tiltAngle, orbitAngle);
 
 	//Uranus moon1
 	distanceFromParent = 0.24f;
 	orbitAngle2 = 10.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject uranusMoon1(moonTexture, (uranus.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.04f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(uranusMoon1);
-	updateGPUGeometry(uranusMoon1.ggeom, uranusMoon1.cgeom);
+	GameObject uranusMoon1(moonTexture, sphereMesh, (uranus.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.04f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Uranus moon2
 	distanceFromParent = 0.35f;
 	orbitAngle2 = 90.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject uranusMoon2(moonTexture, (uranus.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.05f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(uranusMoon2);
-	updateGPUGeometry(uranusMoon2.ggeom, uranusMoon2.cgeom);
+	GameObject uranusMoon2(moonTexture, sphereMesh, (uranus.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.05f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Uranus moon3
 	distanceFromParent = 0.5f;
 	orbitAngle2 = 140.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject uranusMoon3(moonTexture, (uranus.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.06f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(uranusMoon3);
-	updateGPUGeometry(uranusMoon3.ggeom, uranusMoon3.cgeom);
+	GameObject uranusMoon3(moonTexture, sphereMesh, (uranus.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.06f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Neptune
 	distanceFromParent = 44.0f;
 	orbitAngle = 11.8f;
 	tiltAngle = 28.3f;
-	GameObject neptune(neptuneTexture, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.16f, tiltAngle, orbitAngle);
-	tiltAxis(neptune);
-	updateGPUGeometry(neptune.ggeom, neptune.cgeom);
+	GameObject neptune(neptuneTexture, sphereMesh, (sun.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle)), 0.0f }), 0.16f, tiltAngle, orbitAngle);
 
 	//Neptune moon1
 	distanceFromParent = 0.2f;
 	orbitAngle2 = 10.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject neptuneMoon1(moonTexture, (neptune.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.02f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(neptuneMoon1);
-	updateGPUGeometry(neptuneMoon1.ggeom, neptuneMoon1.cgeom);
+	GameObject neptuneMoon1(moonTexture, sphereMesh, (neptune.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.02f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Neptune moon2
 	distanceFromParent = 0.3f;
 	orbitAngle2 = 70.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject neptuneMoon2(moonTexture, (neptune.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.02f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(neptuneMoon2);
-	updateGPUGeometry(neptuneMoon2.ggeom, neptuneMoon2.cgeom);
+	GameObject neptuneMoon2(moonTexture, sphereMesh, (neptune.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.02f, 0.0f, orbitAngle2 + orbitAngle);
 
 	//Neptune moon3
 	distanceFromParent = 0.4f;
 	orbitAngle2 = 100.0f; //from mars orbit angle
 	tiltAngle = 10.0f;
-	GameObject neptuneMoon3(moonTexture, (neptune.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.02f, 0.0f, orbitAngle2 + orbitAngle);
-	tiltAxis(neptuneMoon3);
-	updateGPUGeometry(neptuneMoon3.ggeom, neptuneMoon3.cgeom);
+	GameObject neptuneMoon3(moonTexture, sphereMesh, (neptune.center + glm::vec3{ distanceFromParent * cos(glm::radians(orbitAngle2 + orbitAngle)), distanceFromParent * sin(glm::radians(orbitAngle2 + orbitAngle)), 0.0f }), 0.02f, 0.0f, orbitAngle2 + orbitAngle);
+
+
 
 
+	// seen from the inside, where a cube sphere's square grid looks the most even
+	std::shared_ptr<GameMesh> skyMesh = finishMesh(meshArena, meshBuilder, pendingSky);
 
 
-	GameObject space(spaceTexture, glm::vec3{ 0.0f, 0.0f, 0.0f },200.0f, 0.0f, 0.0f);
-	updateGPUGeometry(space.ggeom, space.cgeom);
+	GameObject space(spaceTexture, skyMesh, glm::vec3{ 0.0f, 0.0f, 0.0f },200.0f, 0.0f, 0.0f);
+	space.sun = 1.0f; // not shaded
+
 
 	CPU_Geometry testceom;
-	GPU_Geometry testgeom;
 	testceom.verts.push_back(glm::vec3(1.0f, 0.0f, 0.0f));
 	testceom.verts.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
 	testceom.verts.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
@@ -668,15 +1055,49 @@ int main() {
 	testceom.cols.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
 	testceom.cols.push_back(glm::vec3(1.0f, 0.0f, 0.0f));
 	testceom.cols.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
-	updateGPUGeometry(testgeom, testceom);
-
+	testceom.indices = { 0, 1, 2, 3, 4, 5 };
+	ArenaMesh axisLines = meshArena.add(testceom, VertexFormat::Float);
+
+
+	// bodies sharing a mesh level and texture are drawn with a single instanced call,
+	// the groups are rebuilt every frame since the level depends on the camera.
+	// Groups sharing a VAO and texture then go out in one multi-draw.
+	std::vector<GameObject*> bodies = { &sun, &earth, &moon, &mercury, &venus, &mars, &marsMoon1, &marsMoon2, &jupiter, &jupiterMoon1, &jupiterMoon2, &jupiterMoon3, &saturn, &saturnMoon1, &saturnMoon2, &saturnMoon3, &uranus, &uranusMoon1, &uranusMoon2, &uranusMoon3, &neptune, &neptuneMoon1, &neptuneMoon2, &neptuneMoon3 };
+	std::vector<InstanceGroup> bodyGroups;
+	std::vector<RingInstance> ringInstances;
+	VertexArray noAttributes; // for drawing from gl_VertexID alone
+	ProceduralSpheres proceduralSpheres;
+	ProceduralSpheres hiddenSpheres; // bodies drawn under conditional rendering
+	UniformBuffer uniforms;
+	DrawCommandBuffer drawCommands(64);
+	InstanceCuller instanceCuller;
+	OcclusionQueries occlusion(a4->getNearPlane());
+	std::vector<Occludee> occludees;
+	// every draw of a frame goes through here, sorted to bind as little as possible
+	RenderQueue renderQueue;
+	RenderQueue::Stats lastRenderStats;
+	double lastStatsLog = 0.0;
+	size_t lastSavedCalls = 0;
+	OcclusionQueries::Stats lastOcclusionStats;
+	CullStats lastCullStats;
+	// the axis lines run from the origin to 1 along each axis
+	const BoundingSphere axisBounds{ glm::vec3(0.0f), 1.0f };
+
+
+
+	ShaderProgram spriteShader("shaders/sprite.vert", "shaders/sprite.frag");
+	CPU_PointSprites spritesc;
+	GPU_PointSprites spritesg;
 
 	glPointSize(10.0f);
+	GLState::enable(GL_PROGRAM_POINT_SIZE); // sprite sizes come from the vertex shader
+
 
 	glm::vec3 orbitAxis2 = glm::vec3{ -sin(glm::radians(moon.orbitAxisAngle)), cos(glm::radians(moon.orbitAxisAngle)), 0.0f };
 	float speed = 1.0f;
 	bool restart = false;
 	auto timeElapsed = glfwGetTime();
+	const SimulationState initialState = saveSimulation(bodies, timeElapsed);
 
 	// RENDER LOOP
 	while (!window.shouldClose()) {
@@ -688,35 +1109,31 @@ int main() {
 
 		glfwPollEvents();
 
-		glEnable(GL_LINE_SMOOTH);
-		glEnable(GL_FRAMEBUFFER_SRGB);
+		// only the sRGB toggle actually reaches GL after the first frame
+		GLState::enable(GL_LINE_SMOOTH);
+		GLState::enable(GL_FRAMEBUFFER_SRGB);
 		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glEnable(GL_DEPTH_TEST);
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-		shader.use();
-
-		a4->viewPipeline(shader);
+		GLState::enable(GL_DEPTH_TEST);
+		GLState::polygonMode(GL_FILL);
 
 		//RESTARTING ANIMATION
 		if (a4->getRestart() != restart) {
-			resetScene(sun, earth, moon, mercury, venus, mars, marsMoon1, marsMoon2, jupiter, jupiterMoon1, jupiterMoon2, jupiterMoon3, saturn, saturnRings, saturnMoon1, saturnMoon2, saturnMoon3, uranus, uranusMoon1, uranusMoon2, uranusMoon3, neptune, neptuneMoon1, neptuneMoon2,  neptuneMoon3);
+			restoreSimulation(initialState, bodies);
 			a4->setRestart();
-			glfwSetTime(0.0f);
-			timeElapsed = 0.0f + dt / speed;
+			timeElapsed = initialState.time + dt / speed;
 		}
 
 		//PLANET TRANSFORMATIONS
 		if (a4->getPause() == false) {
-			sun.transformationMatrix = rotationAxis(45.0f * dt, sun.cgeom.verts[0] - sun.center) * sun.transformationMatrix;
+			sun.transformationMatrix = rotationAxis(45.0f * dt, sun.spinAxis) * sun.transformationMatrix;
 
 			glm::vec3 orbitAxis = glm::vec3{ -sin(glm::radians(earth.orbitAxisAngle)), cos(glm::radians(earth.orbitAxisAngle)), 0.0f };
 			//EARTH ORBIT
 			earth.transformationMatrix = rotationAxis(30.0f * dt, orbitAxis) * earth.transformationMatrix;
 			//EARTH ROTATION
 			//earth.transformationMatrix = translate(earth.transformationMatrix * glm::vec4(earth.center, 1.0f)) * rotationAxis(-(30.0f * dt), orbitAxis) * translate(-(earth.transformationMatrix * glm::vec4(earth.center, 1.0f))) * earth.transformationMatrix;
-			earth.transformationMatrix = translate(earth.transformationMatrix * glm::vec4(earth.center, 1.0f)) * rotationAxis(360.0f * dt, earth.cgeom.verts[0] - earth.center) * translate(-(earth.transformationMatrix * glm::vec4(earth.center, 1.0f))) * earth.transformationMatrix;
+			earth.transformationMatrix = translate(earth.transformationMatrix * glm::vec4(earth.center, 1.0f)) * rotationAxis(360.0f * dt, earth.spinAxis) * translate(-(earth.transformationMatrix * glm::vec4(earth.center, 1.0f))) * earth.transformationMatrix;
 
 			//MOVING WITH EARTH
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(moon.orbitAxisAngle)), cos(glm::radians(moon.orbitAxisAngle)), 0.0f };
@@ -726,116 +1143,114 @@ int main() {
 			moon.transformationMatrix = translate(earth.transformationMatrix * glm::vec4(earth.center, 1.0f)) * rotationAxis(126.0f * dt, orbitAxis2) * translate(-(earth.transformationMatrix * glm::vec4(earth.center, 1.0f))) * moon.transformationMatrix;
 			//MOON ROTATION
 			//moon.transformationMatrix = translate(moon.transformationMatrix * glm::vec4(moon.center, 1.0f)) * rotationAxis(-(126.0f * dt), orbitAxis2) * translate(-(moon.transformationMatrix * glm::vec4(moon.center, 1.0f))) * moon.transformationMatrix;
-			moon.transformationMatrix = translate(moon.transformationMatrix * glm::vec4(moon.center, 1.0f)) * rotationAxis(100.0f * dt, moon.cgeom.verts[0] - moon.center) * translate(-(moon.transformationMatrix * glm::vec4(moon.center, 1.0f))) * moon.transformationMatrix;
+			moon.transformationMatrix = translate(moon.transformationMatrix * glm::vec4(moon.center, 1.0f)) * rotationAxis(100.0f * dt, moon.spinAxis) * translate(-(moon.transformationMatrix * glm::vec4(moon.center, 1.0f))) * moon.transformationMatrix;
 
 
 			//MERCURY
 			orbitAxis = glm::vec3{ -sin(glm::radians(mercury.orbitAxisAngle)), cos(glm::radians(mercury.orbitAxisAngle)), 0.0f };
 			mercury.transformationMatrix = rotationAxis(124.4f * dt, orbitAxis) * mercury.transformationMatrix;
-			mercury.transformationMatrix = translate(mercury.transformationMatrix * glm::vec4(mercury.center, 1.0f)) * rotationAxis(2.05f * dt, mercury.cgeom.verts[0] - mercury.center) * translate(-(mercury.transformationMatrix * glm::vec4(mercury.center, 1.0f))) * mercury.transformationMatrix;
+			mercury.transformationMatrix = translate(mercury.transformationMatrix * glm::vec4(mercury.center, 1.0f)) * rotationAxis(2.05f * dt, mercury.spinAxis) * translate(-(mercury.transformationMatrix * glm::vec4(mercury.center, 1.0f))) * mercury.transformationMatrix;
 
 			//VENUS
 			orbitAxis = glm::vec3{ -sin(glm::radians(venus.orbitAxisAngle)), cos(glm::radians(venus.orbitAxisAngle)), 0.0f };
 			venus.transformationMatrix = rotationAxis(48.7f * dt, orbitAxis) * venus.transformationMatrix;
-			venus.transformationMatrix = translate(venus.transformationMatrix * glm::vec4(venus.center, 1.0f)) * rotationAxis(3.08f * dt, venus.cgeom.verts[0] - venus.center) * translate(-(venus.transformationMatrix * glm::vec4(venus.center, 1.0f))) * venus.transformationMatrix;
+			venus.transformationMatrix = translate(venus.transformationMatrix * glm::vec4(venus.center, 1.0f)) * rotationAxis(3.08f * dt, venus.spinAxis) * translate(-(venus.transformationMatrix * glm::vec4(venus.center, 1.0f))) * venus.transformationMatrix;
 
 			//MARS
 			orbitAxis = glm::vec3{ -sin(glm::radians(mars.orbitAxisAngle)), cos(glm::radians(mars.orbitAxisAngle)), 0.0f };
 			mars.transformationMatrix = rotationAxis(15.9f * dt, orbitAxis) * mars.transformationMatrix;
-			mars.transformationMatrix = translate(mars.transformationMatrix * glm::vec4(mars.center, 1.0f)) * rotationAxis(349.8f * dt, mars.cgeom.verts[0] - mars.center) * translate(-(mars.transformationMatrix * glm::vec4(mars.center, 1.0f))) * mars.transformationMatrix;
+			mars.transformationMatrix = translate(mars.transformationMatrix * glm::vec4(mars.center, 1.0f)) * rotationAxis(349.8f * dt, mars.spinAxis) * translate(-(mars.transformationMatrix * glm::vec4(mars.center, 1.0f))) * mars.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(marsMoon1.orbitAxisAngle)), cos(glm::radians(marsMoon1.orbitAxisAngle)), 0.0f };
 			marsMoon1.transformationMatrix = translate(rotationAxis(15.9f * dt, orbitAxis) * (glm::vec4((marsMoon1.center - mars.center), 1.0f))) * rotationAxis(15.9f * dt, orbitAxis) * translate(-(marsMoon1.center - mars.center)) * marsMoon1.transformationMatrix;
 			marsMoon1.transformationMatrix = translate(mars.transformationMatrix * glm::vec4(mars.center, 1.0f)) * rotationAxis(126.0f * dt, orbitAxis2) * translate(-(mars.transformationMatrix * glm::vec4(mars.center, 1.0f))) * marsMoon1.transformationMatrix;
-			marsMoon1.transformationMatrix = translate(marsMoon1.transformationMatrix * glm::vec4(marsMoon1.center, 1.0f)) * rotationAxis(100.0f * dt, marsMoon1.cgeom.verts[0] - marsMoon1.center) * translate(-(marsMoon1.transformationMatrix * glm::vec4(marsMoon1.center, 1.0f))) * marsMoon1.transformationMatrix;
+			marsMoon1.transformationMatrix = translate(marsMoon1.transformationMatrix * glm::vec4(marsMoon1.center, 1.0f)) * rotationAxis(100.0f * dt, marsMoon1.spinAxis) * translate(-(marsMoon1.transformationMatrix * glm::vec4(marsMoon1.center, 1.0f))) * marsMoon1.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(marsMoon2.orbitAxisAngle)), cos(glm::radians(marsMoon2.orbitAxisAngle)), 0.0f };
 			marsMoon2.transformationMatrix = translate(rotationAxis(15.9f * dt, orbitAxis) * (glm::vec4((marsMoon2.center - mars.center), 1.0f))) * rotationAxis(15.9f * dt, orbitAxis) * translate(-(marsMoon2.center - mars.center)) * marsMoon2.transformationMatrix;
 			marsMoon2.transformationMatrix = translate(mars.transformationMatrix * glm::vec4(mars.center, 1.0f)) * rotationAxis(60.0f * dt, orbitAxis2) * translate(-(mars.transformationMatrix * glm::vec4(mars.center, 1.0f))) * marsMoon2.transformationMatrix;
-			marsMoon2.transformationMatrix = translate(marsMoon2.transformationMatrix * glm::vec4(marsMoon2.center, 1.0f)) * rotationAxis(100.0f * dt, marsMoon2.cgeom.verts[0] - marsMoon2.center) * translate(-(marsMoon2.transformationMatrix * glm::vec4(marsMoon2.center, 1.0f))) * marsMoon2.transformationMatrix;
+			marsMoon2.transformationMatrix = translate(marsMoon2.transformationMatrix * glm::vec4(marsMoon2.center, 1.0f)) * rotationAxis(100.0f * dt, marsMoon2.spinAxis) * translate(-(marsMoon2.transformationMatrix * glm::vec4(marsMoon2.center, 1.0f))) * marsMoon2.transformationMatrix;
 
 			//JUPITER
 			orbitAxis = glm::vec3{ -sin(glm::radians(jupiter.orbitAxisAngle)), cos(glm::radians(jupiter.orbitAxisAngle)), 0.0f };
 			jupiter.transformationMatrix = rotationAxis(2.5f * dt, orbitAxis) * jupiter.transformationMatrix;
-			jupiter.transformationMatrix = translate(jupiter.transformationMatrix * glm::vec4(jupiter.center, 1.0f)) * rotationAxis(872.7f * dt, jupiter.cgeom.verts[0] - jupiter.center) * translate(-(jupiter.transformationMatrix * glm::vec4(jupiter.center, 1.0f))) * jupiter.transformationMatrix;
+			jupiter.transformationMatrix = translate(jupiter.transformationMatrix * glm::vec4(jupiter.center, 1.0f)) * rotationAxis(872.7f * dt, jupiter.spinAxis) * translate(-(jupiter.transformationMatrix * glm::vec4(jupiter.center, 1.0f))) * jupiter.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(jupiterMoon1.orbitAxisAngle)), cos(glm::radians(jupiterMoon1.orbitAxisAngle)), 0.0f };
 			jupiterMoon1.transformationMatrix = translate(rotationAxis(2.5f * dt, orbitAxis) * (glm::vec4((jupiterMoon1.center - jupiter.center), 1.0f))) * rotationAxis(2.5f * dt, orbitAxis) * translate(-(jupiterMoon1.center - jupiter.center)) * jupiterMoon1.transformationMatrix;
 			jupiterMoon1.transformationMatrix = translate(jupiter.transformationMatrix * glm::vec4(jupiter.center, 1.0f)) * rotationAxis(126.0f * dt, orbitAxis2) * translate(-(jupiter.transformationMatrix * glm::vec4(jupiter.center, 1.0f))) * jupiterMoon1.transformationMatrix;
-			jupiterMoon1.transformationMatrix = translate(jupiterMoon1.transformationMatrix * glm::vec4(jupiterMoon1.center, 1.0f)) * rotationAxis(100.0f * dt, jupiterMoon1.cgeom.verts[0] - jupiterMoon1.center) * translate(-(jupiterMoon1.transformationMatrix * glm::vec4(jupiterMoon1.center, 1.0f))) * jupiterMoon1.transformationMatrix;
+			jupiterMoon1.transformationMatrix = translate(jupiterMoon1.transformationMatrix * glm::vec4(jupiterMoon1.center, 1.0f)) * rotationAxis(100.0f * dt, jupiterMoon1.spinAxis) * translate(-(jupiterMoon1.transformationMatrix * glm::vec4(jupiterMoon1.center, 1.0f))) * jupiterMoon1.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(jupiterMoon2.orbitAxisAngle)), cos(glm::radians(jupiterMoon2.orbitAxisAngle)), 0.0f };
 			jupiterMoon2.transformationMatrix = translate(rotationAxis(2.5f * dt, orbitAxis) * (glm::vec4((jupiterMoon2.center - jupiter.center), 1.0f))) * rotationAxis(2.5f * dt, orbitAxis) * translate(-(jupiterMoon2.center - jupiter.center)) * jupiterMoon2.transformationMatrix;
 			jupiterMoon2.transformationMatrix = translate(jupiter.transformationMatrix * glm::vec4(jupiter.center, 1.0f)) * rotationAxis(80.0f * dt, orbitAxis2) * translate(-(jupiter.transformationMatrix * glm::vec4(jupiter.center, 1.0f))) * jupiterMoon2.transformationMatrix;
-			jupiterMoon2.transformationMatrix = translate(jupiterMoon2.transformationMatrix * glm::vec4(jupiterMoon2.center, 1.0f)) * rotationAxis(100.0f * dt, jupiterMoon2.cgeom.verts[0] - jupiterMoon2.center) * translate(-(jupiterMoon2.transformationMatrix * glm::vec4(jupiterMoon2.center, 1.0f))) * jupiterMoon2.transformationMatrix;
+			jupiterMoon2.transformationMatrix = translate(jupiterMoon2.transformationMatrix * glm::vec4(jupiterMoon2.center, 1.0f)) * rotationAxis(100.0f * dt, jupiterMoon2.spinAxis) * translate(-(jupiterMoon2.transformationMatrix * glm::vec4(jupiterMoon2.center, 1.0f))) * jupiterMoon2.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(jupiterMoon3.orbitAxisAngle)), cos(glm::radians(jupiterMoon3.orbitAxisAngle)), 0.0f };
 			jupiterMoon3.transformationMatrix = translate(rotationAxis(2.5f * dt, orbitAxis) * (glm::vec4((jupiterMoon3.center - jupiter.center), 1.0f))) * rotationAxis(2.5f * dt, orbitAxis) * translate(-(jupiterMoon3.center - jupiter.center)) * jupiterMoon3.transformationMatrix;
 			jupiterMoon3.transformationMatrix = translate(jupiter.transformationMatrix * glm::vec4(jupiter.center, 1.0f)) * rotationAxis(40.0f * dt, orbitAxis2) * translate(-(jupiter.transformationMatrix * glm::vec4(jupiter.center, 1.0f))) * jupiterMoon3.transformationMatrix;
-			jupiterMoon3.transformationMatrix = translate(jupiterMoon3.transformationMatrix * glm::vec4(jupiterMoon3.center, 1.0f)) * rotationAxis(100.0f * dt, jupiterMoon3.cgeom.verts[0] - jupiterMoon3.center) * translate(-(jupiterMoon3.transformationMatrix * glm::vec4(jupiterMoon3.center, 1.0f))) * jupiterMoon3.transformationMatrix;
+			jupiterMoon3.transformationMatrix = translate(jupiterMoon3.transformationMatrix * glm::vec4(jupiterMoon3.center, 1.0f)) * rotationAxis(100.0f * dt, jupiterMoon3.spinAxis) * translate(-(jupiterMoon3.transformationMatrix * glm::vec4(jupiterMoon3.center, 1.0f))) * jupiterMoon3.transformationMatrix;
 
 			//SATURN
 			orbitAxis = glm::vec3{ -sin(glm::radians(saturn.orbitAxisAngle)), cos(glm::radians(saturn.orbitAxisAngle)), 0.0f };
 			saturn.transformationMatrix = rotationAxis(1.02f * dt, orbitAxis) * saturn.transformationMatrix;
-			saturn.transformationMatrix = translate(saturn.transformationMatrix * glm::vec4(saturn.center, 1.0f)) * rotationAxis(807.5f * dt, saturn.cgeom.verts[0] - saturn.center) * translate(-(saturn.transformationMatrix * glm::vec4(saturn.center, 1.0f))) * saturn.transformationMatrix;
+			saturn.transformationMatrix = translate(saturn.transformationMatrix * glm::vec4(saturn.center, 1.0f)) * rotationAxis(807.5f * dt, saturn.spinAxis) * translate(-(saturn.transformationMatrix * glm::vec4(saturn.center, 1.0f))) * saturn.transformationMatrix;
 
-			saturnRings.transformationMatrix = rotationAxis(1.02f * dt, orbitAxis) * saturnRings.transformationMatrix;
-			//saturnRings.transformationMatrix = translate(saturnRings.transformationMatrix * glm::vec4(saturnRings.center, 1.0f)) * rotationAxis(807.5f * dt, saturnRings.cgeom.verts[0] - saturnRings.center) * translate(-(saturnRings.transformationMatrix * glm::vec4(saturnRings.center, 1.0f))) * saturnRings.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(saturnMoon1.orbitAxisAngle)), cos(glm::radians(saturnMoon1.orbitAxisAngle)), 0.0f };
 			saturnMoon1.transformationMatrix = translate(rotationAxis(1.02f * dt, orbitAxis) * (glm::vec4((saturnMoon1.center - saturn.center), 1.0f))) * rotationAxis(1.02f * dt, orbitAxis) * translate(-(saturnMoon1.center - saturn.center)) * saturnMoon1.transformationMatrix;
 			saturnMoon1.transformationMatrix = translate(saturn.transformationMatrix * glm::vec4(saturn.center, 1.0f)) * rotationAxis(126.0f * dt, orbitAxis2) * translate(-(saturn.transformationMatrix * glm::vec4(saturn.center, 1.0f))) * saturnMoon1.transformationMatrix;
-			saturnMoon1.transformationMatrix = translate(saturnMoon1.transformationMatrix * glm::vec4(saturnMoon1.center, 1.0f)) * rotationAxis(100.0f * dt, saturnMoon1.cgeom.verts[0] - saturnMoon1.center) * translate(-(saturnMoon1.transformationMatrix * glm::vec4(saturnMoon1.center, 1.0f))) * saturnMoon1.transformationMatrix;
+			saturnMoon1.transformationMatrix = translate(saturnMoon1.transformationMatrix * glm::vec4(saturnMoon1.center, 1.0f)) * rotationAxis(100.0f * dt, saturnMoon1.spinAxis) * translate(-(saturnMoon1.transformationMatrix * glm::vec4(saturnMoon1.center, 1.0f))) * saturnMoon1.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(saturnMoon2.orbitAxisAngle)), cos(glm::radians(saturnMoon2.orbitAxisAngle)), 0.0f };
 			saturnMoon2.transformationMatrix = translate(rotationAxis(1.02f * dt, orbitAxis) * (glm::vec4((saturnMoon2.center - saturn.center), 1.0f))) * rotationAxis(1.02f * dt, orbitAxis) * translate(-(saturnMoon2.center - saturn.center)) * saturnMoon2.transformationMatrix;
 			saturnMoon2.transformationMatrix = translate(saturn.transformationMatrix * glm::vec4(saturn.center, 1.0f)) * rotationAxis(70.0f * dt, orbitAxis2) * translate(-(saturn.transformationMatrix * glm::vec4(saturn.center, 1.0f))) * saturnMoon2.transformationMatrix;
-			saturnMoon2.transformationMatrix = translate(saturnMoon2.transformationMatrix * glm::vec4(saturnMoon2.center, 1.0f)) * rotationAxis(100.0f * dt, saturnMoon2.cgeom.verts[0] - saturnMoon2.center) * translate(-(saturnMoon2.transformationMatrix * glm::vec4(saturnMoon2.center, 1.0f))) * saturnMoon2.transformationMatrix;
+			saturnMoon2.transformationMatrix = translate(saturnMoon2.transformationMatrix * glm::vec4(saturnMoon2.center, 1.0f)) * rotationAxis(100.0f * dt, saturnMoon2.spinAxis) * translate(-(saturnMoon2.transformationMatrix * glm::vec4(saturnMoon2.center, 1.0f))) * saturnMoon2.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(saturnMoon3.orbitAxisAngle)), cos(glm::radians(saturnMoon3.orbitAxisAngle)), 0.0f };
 			saturnMoon3.transformationMatrix = translate(rotationAxis(1.02f * dt, orbitAxis) * (glm::vec4((saturnMoon3.center - saturn.center), 1.0f))) * rotationAxis(1.02f * dt, orbitAxis) * translate(-(saturnMoon3.center - saturn.center)) * saturnMoon3.transformationMatrix;
 			saturnMoon3.transformationMatrix = translate(saturn.transformationMatrix * glm::vec4(saturn.center, 1.0f)) * rotationAxis(50.0f * dt, orbitAxis2) * translate(-(saturn.transformationMatrix * glm::vec4(saturn.center, 1.0f))) * saturnMoon3.transformationMatrix;
-			saturnMoon3.transformationMatrix = translate(saturnMoon3.transformationMatrix * glm::vec4(saturnMoon3.center, 1.0f)) * rotationAxis(100.0f * dt, saturnMoon3.cgeom.verts[0] - saturnMoon3.center) * translate(-(saturnMoon3.transformationMatrix * glm::vec4(saturnMoon3.center, 1.0f))) * saturnMoon3.transformationMatrix;
+			saturnMoon3.transformationMatrix = translate(saturnMoon3.transformationMatrix * glm::vec4(saturnMoon3.center, 1.0f)) * rotationAxis(100.0f * dt, saturnMoon3.spinAxis) * translate(-(saturnMoon3.transformationMatrix * glm::vec4(saturnMoon3.center, 1.0f))) * saturnMoon3.transformationMatrix;
 
 			//URANUS
 			orbitAxis = glm::vec3{ -sin(glm::radians(uranus.orbitAxisAngle)), cos(glm::radians(uranus.orbitAxisAngle)), 0.0f };
 			uranus.transformationMatrix = rotationAxis(0.4f * dt, orbitAxis) * uranus.transformationMatrix;
-			uranus.transformationMatrix = translate(uranus.transformationMatrix * glm::vec4(uranus.center, 1.0f)) * rotationAxis(502.3f * dt, uranus.cgeom.verts[0] - uranus.center) * translate(-(uranus.transformationMatrix * glm::vec4(uranus.center, 1.0f))) * uranus.transformationMatrix;
+			uranus.transformationMatrix = translate(uranus.transformationMatrix * glm::vec4(uranus.center, 1.0f)) * rotationAxis(502.3f * dt, uranus.spinAxis) * translate(-(uranus.transformationMatrix * glm::vec4(uranus.center, 1.0f))) * uranus.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(uranusMoon1.orbitAxisAngle)), cos(glm::radians(uranusMoon1.orbitAxisAngle)), 0.0f };
 			uranusMoon1.transformationMatrix = translate(rotationAxis(0.4f * dt, orbitAxis) * (glm::vec4((uranusMoon1.center - uranus.center), 1.0f))) * rotationAxis(0.4f * dt, orbitAxis) * translate(-(uranusMoon1.center - uranus.center)) * uranusMoon1.transformationMatrix;
 			uranusMoon1.transformationMatrix = translate(uranus.transformationMatrix * glm::vec4(uranus.center, 1.0f)) * rotationAxis(126.0f * dt, orbitAxis2) * translate(-(uranus.transformationMatrix * glm::vec4(uranus.center, 1.0f))) * uranusMoon1.transformationMatrix;
-			uranusMoon1.transformationMatrix = translate(uranusMoon1.transformationMatrix * glm::vec4(uranusMoon1.center, 1.0f)) * rotationAxis(100.0f * dt, uranusMoon1.cgeom.verts[0] - uranusMoon1.center) * translate(-(uranusMoon1.transformationMatrix * glm::vec4(uranusMoon1.center, 1.0f))) * uranusMoon1.transformationMatrix;
+			uranusMoon1.transformationMatrix = translate(uranusMoon1.transformationMatrix * glm::vec4(uranusMoon1.center, 1.0f)) * rotationAxis(100.0f * dt, uranusMoon1.spinAxis) * translate(-(uranusMoon1.transformationMatrix * glm::vec4(uranusMoon1.center, 1.0f))) * uranusMoon1.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(uranusMoon2.orbitAxisAngle)), cos(glm::radians(uranusMoon2.orbitAxisAngle)), 0.0f };
 			uranusMoon2.transformationMatrix = translate(rotationAxis(0.4f * dt, orbitAxis) * (glm::vec4((uranusMoon2.center - uranus.center), 1.0f))) * rotationAxis(0.4f * dt, orbitAxis) * translate(-(uranusMoon2.center - uranus.center)) * uranusMoon2.transformationMatrix;
 			uranusMoon2.transformationMatrix = translate(uranus.transformationMatrix * glm::vec4(uranus.center, 1.0f)) * rotationAxis(60.0f * dt, orbitAxis2) * translate(-(uranus.transformationMatrix * glm::vec4(uranus.center, 1.0f))) * uranusMoon2.transformationMatrix;
-			uranusMoon2.transformationMatrix = translate(uranusMoon2.transformationMatrix * glm::vec4(uranusMoon2.center, 1.0f)) * rotationAxis(100.0f * dt, uranusMoon2.cgeom.verts[0] - uranusMoon2.center) * translate(-(uranusMoon2.transformationMatrix * glm::vec4(uranusMoon2.center, 1.0f))) * uranusMoon2.transformationMatrix;
+			uranusMoon2.transformationMatrix = translate(uranusMoon2.transformationMatrix * glm::vec4(uranusMoon2.center, 1.0f)) * rotationAxis(100.0f * dt, uranusMoon2.spinAxis) * translate(-(uranusMoon2.transformationMatrix * glm::vec4(uranusMoon2.center, 1.0f))) * uranusMoon2.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(uranusMoon3.orbitAxisAngle)), cos(glm::radians(uranusMoon3.orbitAxisAngle)), 0.0f };
 			uranusMoon3.transformationMatrix = translate(rotationAxis(0.4f * dt, orbitAxis) * (glm::vec4((uranusMoon3.center - uranus.center), 1.0f))) * rotationAxis(0.4f * dt, orbitAxis) * translate(-(uranusMoon3.center - uranus.center)) * uranusMoon3.transformationMatrix;
 			uranusMoon3.transformationMatrix = translate(uranus.transformationMatrix * glm::vec4(uranus.center, 1.0f)) * rotationAxis(30.0f * dt, orbitAxis2) * translate(-(uranus.transformationMatrix * glm::vec4(uranus.center, 1.0f))) * uranusMoon3.transformationMatrix;
-			uranusMoon3.transformationMatrix = translate(uranusMoon3.transformationMatrix * glm::vec4(uranusMoon3.center, 1.0f)) * rotationAxis(100.0f * dt, moon.cgeom.verts[0] - uranusMoon3.center) * translate(-(uranusMoon3.transformationMatrix * glm::vec4(uranusMoon3.center, 1.0f))) * uranusMoon3.transformationMatrix;
+			uranusMoon3.transformationMatrix = translate(uranusMoon3.transformationMatrix * glm::vec4(uranusMoon3.center, 1.0f)) * rotationAxis(100.0f * dt, uranusMoon3.spinAxis) * translate(-(uranusMoon3.transformationMatrix * glm::vec4(uranusMoon3.center, 1.0f))) * uranusMoon3.transformationMatrix;
 
 			//NEPTUNE
 			orbitAxis = glm::vec3{ -sin(glm::radians(neptune.orbitAxisAngle)), cos(glm::radians(neptune.orbitAxisAngle)), 0.0f };
 			neptune.transformationMatrix = rotationAxis(0.3f * dt, orbitAxis) * neptune.transformationMatrix;
-			neptune.transformationMatrix = translate(neptune.transformationMatrix * glm::vec4(neptune.center, 1.0f)) * rotationAxis(536.6f * dt, neptune.cgeom.verts[0] - neptune.center) * translate(-(neptune.transformationMatrix * glm::vec4(neptune.center, 1.0f))) * neptune.transformationMatrix;
+			neptune.transformationMatrix = translate(neptune.transformationMatrix * glm::vec4(neptune.center, 1.0f)) * rotationAxis(536.6f * dt, neptune.spinAxis) * translate(-(neptune.transformationMatrix * glm::vec4(neptune.center, 1.0f))) * neptune.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(neptuneMoon1.orbitAxisAngle)), cos(glm::radians(neptuneMoon1.orbitAxisAngle)), 0.0f };
 			neptuneMoon1.transformationMatrix = translate(rotationAxis(0.3f * dt, orbitAxis) * (glm::vec4((neptuneMoon1.center - neptune.center), 1.0f))) * rotationAxis(0.3f * dt, orbitAxis) * translate(-(neptuneMoon1.center - neptune.center)) * neptuneMoon1.transformationMatrix;
 			neptuneMoon1.transformationMatrix = translate(neptune.transformationMatrix * glm::vec4(neptune.center, 1.0f)) * rotationAxis(126.0f * dt, orbitAxis2) * translate(-(neptune.transformationMatrix * glm::vec4(neptune.center, 1.0f))) * neptuneMoon1.transformationMatrix;
-			neptuneMoon1.transformationMatrix = translate(neptuneMoon1.transformationMatrix * glm::vec4(neptuneMoon1.center, 1.0f)) * rotationAxis(100.0f * dt, neptuneMoon1.cgeom.verts[0] - neptuneMoon1.center) * translate(-(neptuneMoon1.transformationMatrix * glm::vec4(neptuneMoon1.center, 1.0f))) * neptuneMoon1.transformationMatrix;
+			neptuneMoon1.transformationMatrix = translate(neptuneMoon1.transformationMatrix * glm::vec4(neptuneMoon1.center, 1.0f)) * rotationAxis(100.0f * dt, neptuneMoon1.spinAxis) * translate(-(neptuneMoon1.transformationMatrix * glm::vec4(neptuneMoon1.center, 1.0f))) * neptuneMoon1.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(neptuneMoon2.orbitAxisAngle)), cos(glm::radians(neptuneMoon2.orbitAxisAngle)), 0.0f };
 			neptuneMoon2.transformationMatrix = translate(rotationAxis(0.3f * dt, orbitAxis) * (glm::vec4((neptuneMoon2.center - neptune.center), 1.0f))) * rotationAxis(0.3f * dt, orbitAxis) * translate(-(neptuneMoon2.center - neptune.center)) * neptuneMoon2.transformationMatrix;
 			neptuneMoon2.transformationMatrix = translate(neptune.transformationMatrix * glm::vec4(neptune.center, 1.0f)) * rotationAxis(126.0f * dt, orbitAxis2) * translate(-(neptune.transformationMatrix * glm::vec4(neptune.center, 1.0f))) * neptuneMoon2.transformationMatrix;
-			neptuneMoon2.transformationMatrix = translate(neptuneMoon2.transformationMatrix * glm::vec4(neptuneMoon2.center, 1.0f)) * rotationAxis(100.0f * dt, neptuneMoon2.cgeom.verts[0] - neptuneMoon2.center) * translate(-(neptuneMoon2.transformationMatrix * glm::vec4(neptuneMoon2.center, 1.0f))) * neptuneMoon2.transformationMatrix;
+			neptuneMoon2.transformationMatrix = translate(neptuneMoon2.transformationMatrix * glm::vec4(neptuneMoon2.center, 1.0f)) * rotationAxis(100.0f * dt, neptuneMoon2.spinAxis) * translate(-(neptuneMoon2.transformationMatrix * glm::vec4(neptuneMoon2.center, 1.0f))) * neptuneMoon2.transformationMatrix;
 
 			orbitAxis2 = glm::vec3{ -sin(glm::radians(neptuneMoon3.orbitAxisAngle)), cos(glm::radians(neptuneMoon3.orbitAxisAngle)), 0.0f };
 			neptuneMoon3.transformationMatrix = translate(rotationAxis(0.3f * dt, orbitAxis) * (glm::vec4((neptuneMoon3.center - neptune.center), 1.0f))) * rotationAxis(0.3f * dt, orbitAxis) * translate(-(neptuneMoon3.center - neptune.center)) * neptuneMoon3.transformationMatrix;
 			neptuneMoon3.transformationMatrix = translate(neptune.transformationMatrix * glm::vec4(neptune.center, 1.0f)) * rotationAxis(126.0f * dt, orbitAxis2) * translate(-(neptune.transformationMatrix * glm::vec4(neptune.center, 1.0f))) * neptuneMoon3.transformationMatrix;
-			neptuneMoon3.transformationMatrix = translate(neptuneMoon3.transformationMatrix * glm::vec4(neptuneMoon3.center, 1.0f)) * rotationAxis(100.0f * dt, neptuneMoon3.cgeom.verts[0] - neptuneMoon3.center) * translate(-(neptuneMoon3.transformationMatrix * glm::vec4(neptuneMoon3.center, 1.0f))) * neptuneMoon3.transformationMatrix;
+			neptuneMoon3.transformationMatrix = translate(neptuneMoon3.transformationMatrix * glm::vec4(neptuneMoon3.center, 1.0f)) * rotationAxis(100.0f * dt, neptuneMoon3.spinAxis) * translate(-(neptuneMoon3.transformationMatrix * glm::vec4(neptuneMoon3.center, 1.0f))) * neptuneMoon3.transformationMatrix;
 
 		}
 		else {
@@ -844,65 +1259,113 @@ int main() {
 			glfwSetTime(timeElapsed);
 		}
 
-		float s = 1.0f;
-		GLint loc = glGetUniformLocation(shader, "sun");
-		GLint uniMat = glGetUniformLocation(shader, "M");
-		GLint centerloc = glGetUniformLocation(shader, "center");
-		GLint normalLoc = glGetUniformLocation(shader, "Norm");
-
-		//SUN
-		glUniform1f(loc, s);
-		drawPlanet(sun, shader);
-
-		//EARTH
-		s = 0.0f;
-		glUniform1f(loc, s);
-		drawPlanet(earth, shader);
-
-		//MOON
-		drawPlanet(moon, shader);
-
-		//ALL OTHER PLANETS AND THEIR MOONS
-		drawPlanet(mercury, shader);
-		drawPlanet(venus, shader);
-		drawPlanet(mars, shader);
-		drawPlanet(marsMoon1, shader);
-		drawPlanet(marsMoon2, shader);
-		drawPlanet(jupiter, shader);
-		drawPlanet(jupiterMoon1, shader);
-		drawPlanet(jupiterMoon2, shader);
-		drawPlanet(jupiterMoon3, shader);
-		drawPlanet(saturn, shader);
-		drawPlanet(saturnRings, shader);
-		drawPlanet(saturnMoon1, shader);
-		drawPlanet(saturnMoon2, shader);
-		drawPlanet(saturnMoon3, shader);
-		drawPlanet(uranus, shader);
-		drawPlanet(uranusMoon1, shader);
-		drawPlanet(uranusMoon2, shader);
-		drawPlanet(uranusMoon3, shader);
-		drawPlanet(neptune, shader);
-		drawPlanet(neptuneMoon1, shader);
-		drawPlanet(neptuneMoon2, shader);
-		drawPlanet(neptuneMoon3, shader);
+		FrameBlock frame = a4->viewPipeline();
+		Frustum frustum(frame.P * frame.V);
+		CullStats cullStats;
+
+		//SUN, PLANETS AND THEIR MOONS
+		// the procedural spheres read their own instance buffer, so only the mesh path culls on the GPU
+		bool gpuCulling = a4->getGpuCulling() && !a4->getProceduralSpheres();
+		OcclusionQueries* occlusionQueries = nullptr;
+		if (a4->getOcclusionCulling()) {
+			occlusion.collect();
+			occlusionQueries = &occlusion;
+		}
+		selectLods(bodies, sphereLods, *a4, frustum, !gpuCulling, bodyGroups, spritesc, ringInstances, cullStats,
+			occlusionQueries, occludees);
+
+		//UNIFORM BLOCKS, everything the draws below read, in one upload
+		uniforms.clear();
+		size_t frameBlock = uniforms.add(frame);
+		addRingBlocks(ringInstances, uniforms);
+		size_t spaceBlock = uniforms.add(objectBlock(space));
+		size_t axisBlock = uniforms.add(ObjectBlock{ glm::mat4(1.0f), glm::vec3(0.0f), 1.0f });
+		uniforms.upload();
+		uniforms.bind(FRAME_BLOCK_BINDING, frameBlock);
+
+		if (a4->getProceduralSpheres()) {
+			queueProcedural(bodyGroups, sphereLods, proceduralSpheres, sphereShader, *a4, renderQueue);
+		}
+		if (gpuCulling) {
+			queueGpuCulled(bodyGroups, meshArena, instanceCuller, instancedShader, *a4, renderQueue);
+		}
+		else {
+			drawCommands.clear();
+			queueInstanced(bodyGroups, meshArena, instancedShader, *a4, drawCommands, renderQueue);
+			drawCommands.upload();
+		}
 
-		//SPACE
-		s = 1.0f;
-		glUniform1f(loc, s);
-		glUniformMatrix4fv(uniMat, 1, GL_FALSE, glm::value_ptr(space.transformationMatrix));
+		//RINGS
+		queueRings(ringInstances, noAttributes, ringShader, uniforms, *a4, renderQueue);
+		//BODIES BEHIND OTHER BODIES
+		queueOcclusion(occludees, occlusion, meshArena, hiddenSpheres, a4->getProceduralSpheres(),
+			instancedShader, sphereShader, *a4, renderQueue);
+
+
+		//BODIES TOO SMALL FOR A MESH
+		if (!spritesc.verts.empty()) {
+			spritesg.upload(spritesc);
+			GLsizei spriteCount = GLsizei(spritesc.verts.size());
+			renderQueue.submit(RenderCommand{
+				RenderQueue::makeKey(RenderPass::Opaque, spriteShader, 0, 0.0f),
+				&spriteShader, nullptr, &spritesg.vertexArray(),
+				[spriteCount] { glDrawArrays(GL_POINTS, 0, spriteCount); } });
+		}
 
-		space.ggeom.bind();
-		space.texture->textures.bind();
-		glDrawArrays(GL_TRIANGLES, 0, GLsizei(space.cgeom.verts.size()));
-		space.texture->textures.bind();
+		//SPACE
+		if (isVisible(frustum, space.bounds(), cullStats)) {
+			queuePlanet(space, RenderPass::Sky, meshArena, shader, uniforms, spaceBlock, *a4, renderQueue);
+		}
 
 		//X, Y, Z AXIS
-		testgeom.bind();
-		glDrawArrays(GL_LINE_STRIP, 0, GLsizei(testceom.verts.size()));
+		if (isVisible(frustum, axisBounds, cullStats)) {
+			renderQueue.submit(RenderCommand{
+				RenderQueue::makeKey(RenderPass::Overlay, shader, 0, 0.0f),
+				&shader, nullptr, &meshArena.vertexArray(axisLines.format),
+				[&uniforms, axisBlock, axisLines] {
+					uniforms.bind(OBJECT_BLOCK_BINDING, axisBlock);
+					glDrawElementsBaseVertex(GL_LINE_STRIP, axisLines.indexCount, GL_UNSIGNED_INT, axisLines.indices(), axisLines.baseVertex);
+				} });
+		}
+
+		// the stats below change most frames, so they're logged at most once a second
+		const bool logStats = newTimeEleapsed - lastStatsLog >= 1.0;
+		if (logStats) {
+			lastStatsLog = newTimeEleapsed;
+		}
+
+		if (logStats && cullStats != lastCullStats) {
+			Log::info("FRUSTUM CULLING {} of {} objects culled", cullStats.culled, cullStats.tested);
+			lastCullStats = cullStats;
+		}
+
+
+		RenderQueue::Stats renderStats = renderQueue.flush();
+		if (logStats && renderStats != lastRenderStats) {
+			Log::info("RENDER QUEUE {} draws, {} program binds, {} texture binds, {} VAO binds",
+				renderStats.draws, renderStats.shaderBinds, renderStats.textureBinds, renderStats.vertexArrayBinds);
+			lastRenderStats = renderStats;
+		}
+
+		OcclusionQueries::Stats occlusionStats = occlusion.takeStats();
+		if (logStats && occlusionStats != lastOcclusionStats) {
+			Log::info("OCCLUSION {} proxies queried, {} bodies found hidden, {} draws left to conditional rendering",
+				occlusionStats.queried, occlusionStats.hidden, occlusionStats.conditional);
+			lastOcclusionStats = occlusionStats;
+		}
+
+		GLState::disable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui
+		size_t savedCalls = GLState::takeSavedCalls();
+		if (logStats && savedCalls != lastSavedCalls) {
+			Log::info("GL STATE {} redundant calls dropped this frame", savedCalls);
+			lastSavedCalls = savedCalls;
+		}
+
+		StreamBuffer::endFrame(); // fences this frame's instance, sprite, uniform and draw command data
 
-		glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui
 		window.swapBuffers();
 
+
 		if (a4->getSpeed() != speed) {
 			speed = a4->getSpeed();
 		}
@@ -0,0 +1,41 @@
+#version 330 core
+
+in vec3 fragPos;
+in vec2 fragColor;
+in vec3 n;
+in vec3 fragLight;
+in float fragSun;
+flat in int fragLayer;
+
+// shared by every program, see UniformBuffer.h
+layout (std140) uniform Frame {
+	mat4 V;
+	mat4 P;
+	vec3 lightPosition;
+};
+
+out vec4 color;
+uniform sampler2DArray sampler; // every body texture, one per layer
+uniform float diffStrength = 1.0;
+uniform float ambient = 0.02;
+uniform float specStrength = 0.02;
+uniform float shineinessCoefficient = 0.3;
+
+void main() {
+	vec3 viewDir = lightPosition - fragPos;
+	vec3 lightDir = normalize(fragLight - fragPos);
+	vec3 normal = normalize(n);
+	float diff = max(dot(lightDir, normal), 0.0);
+	diff = diffStrength * diff;
+	vec3 r = 2.0f * diff * normal + lightDir;
+	float specular = max(dot(viewDir, r), 0.0);
+	specular = specStrength * pow(specular, shineinessCoefficient);
+
+	color = texture(sampler, vec3(fragColor, fragLayer));
+	if (fragSun == 1.0f){
+		color = color;
+	}
+	else {
+		color = (diff + ambient + specular) * color;
+	}
+}
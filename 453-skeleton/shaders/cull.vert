@@ -0,0 +1,45 @@
+#version 330 core
+// One point per instance, no mesh. Tests the instance's bounding sphere against
+// the view frustum and hands the instance to cull.geom, which only passes it on
+// to transform feedback if it is visible. Nothing is rasterized.
+layout (location = 0) in mat4 M; // uses locations 0 to 3
+layout (location = 4) in vec2 material;
+
+// shared by every program, see UniformBuffer.h
+layout (std140) uniform Frame {
+	mat4 V;
+	mat4 P;
+	vec3 lightPosition;
+};
+
+// radius around the mesh's origin that the whole mesh fits in, before M
+uniform float boundingRadius;
+
+out mat4 vertexM;
+out vec2 vertexMaterial;
+flat out int visible;
+
+void main() {
+	vertexM = M;
+	vertexMaterial = material;
+
+	vec3 center = vec3(M[3]);
+	float scale = max(length(vec3(M[0])), max(length(vec3(M[1])), length(vec3(M[2]))));
+	float radius = boundingRadius * scale;
+
+	// the frustum planes, same as Frustum.cpp, from the rows of P * V
+	mat4 PV = P * V;
+	vec4 x = vec4(PV[0][0], PV[1][0], PV[2][0], PV[3][0]);
+	vec4 y = vec4(PV[0][1], PV[1][1], PV[2][1], PV[3][1]);
+	vec4 z = vec4(PV[0][2], PV[1][2], PV[2][2], PV[3][2]);
+	vec4 w = vec4(PV[0][3], PV[1][3], PV[2][3], PV[3][3]);
+	vec4 planes[6] = vec4[6](w + x, w - x, w + y, w - y, w + z, w - z);
+
+	visible = 1;
+	for (int i = 0; i < 6; i++) {
+		// planes aren't normalized, so the radius is scaled instead
+		if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz)) {
+			visible = 0;
+		}
+	}
+}
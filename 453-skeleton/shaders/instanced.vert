@@ -0,0 +1,33 @@
+#version 330 core
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 color;
+layout (location = 2) in vec3 normal;
+layout (location = 3) in mat4 M; // per instance, uses locations 3 to 6
+layout (location = 7) in vec2 material; // per instance, texture array layer and 1 for the sun
+
+// shared by every program, see UniformBuffer.h
+layout (std140) uniform Frame {
+	mat4 V;
+	mat4 P;
+	vec3 lightPosition;
+};
+
+uniform vec3 light = vec3(0.0f, 0.0f, 0.0f);
+
+out vec3 fragPos;
+out vec2 fragColor;
+out vec3 n;
+out vec3 fragLight;
+out float fragSun;
+flat out int fragLayer;
+
+void main() {
+	fragSun = material.y;
+	fragLayer = int(material.x);
+	fragLight = light;
+	fragPos = vec3(M * vec4(pos, 1.0));
+	fragColor = color;
+	// meshes are centered on the origin of their own space
+	n = fragPos - vec3(M * vec4(0.0, 0.0, 0.0, 1.0));
+	gl_Position = P * V * M * vec4(pos, 1.0);
+}
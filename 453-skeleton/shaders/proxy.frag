@@ -0,0 +1,6 @@
+#version 330 core
+// Colour writes are off while proxies are drawn, only the samples that pass
+// the depth test are counted.
+
+void main() {
+}
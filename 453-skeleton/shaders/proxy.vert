@@ -0,0 +1,30 @@
+#version 330 core
+// No vertex attributes, a box around a bounding sphere made from gl_VertexID
+// alone. It is drawn as 36 GL_TRIANGLES vertices for occlusion queries, so
+// only its depth matters.
+
+// shared by every program, see UniformBuffer.h
+layout (std140) uniform Frame {
+	mat4 V;
+	mat4 P;
+	vec3 lightPosition;
+};
+
+uniform vec3 center;
+uniform float radius;
+
+// corners of the unit cube, bit 0 is x, bit 1 is y and bit 2 is z
+const int CORNERS[36] = int[36](
+	0, 2, 1, 1, 2, 3, // -z
+	4, 5, 6, 5, 7, 6, // +z
+	0, 1, 4, 1, 5, 4, // -y
+	2, 6, 3, 3, 6, 7, // +y
+	0, 4, 2, 2, 4, 6, // -x
+	1, 3, 5, 3, 7, 5  // +x
+);
+
+void main() {
+	int corner = CORNERS[gl_VertexID];
+	vec3 unit = vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * 2.0 - 1.0;
+	gl_Position = P * V * vec4(center + radius * unit, 1.0);
+}
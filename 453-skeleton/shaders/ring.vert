@@ -0,0 +1,45 @@
+#version 330 core
+// No vertex attributes, the ring is made from gl_VertexID alone. It is drawn as a
+// GL_TRIANGLE_STRIP of 2 * (segments + 1) vertices that alternate between the
+// inner and the outer edge, going around the y axis.
+
+// shared by every program, see UniformBuffer.h
+layout (std140) uniform Frame {
+	mat4 V;
+	mat4 P;
+	vec3 lightPosition;
+};
+
+// one per draw
+layout (std140) uniform Ring {
+	mat4 M;
+	float innerRadius;
+	float outerRadius;
+	int segments;
+};
+
+uniform vec3 light = vec3(0.0f, 0.0f, 0.0f);
+
+out vec3 fragPos;
+out vec2 fragColor;
+out vec3 n;
+out vec3 fragLight;
+out float fragSun;
+
+const float PI = 3.14159265358979;
+
+void main() {
+	int edge = gl_VertexID % 2; // 0 inner, 1 outer
+	float around = float(gl_VertexID / 2) / float(segments);
+	float angle = 2.0 * PI * around;
+	float radius = mix(innerRadius, outerRadius, float(edge));
+	vec3 pos = radius * vec3(cos(angle), 0.0, -sin(angle));
+
+	fragSun = 0.0;
+	fragLight = light;
+	fragPos = vec3(M * vec4(pos, 1.0));
+	// across the band, then around it
+	fragColor = vec2(float(edge), around);
+	n = fragPos - vec3(M * vec4(0.0, 0.0, 0.0, 1.0));
+	gl_Position = P * V * M * vec4(pos, 1.0);
+}
@@ -0,0 +1,52 @@
+#version 330 core
+// No vertex data for the sphere itself, every vertex of a unit UV sphere is made
+// from gl_VertexID. It is drawn as GL_TRIANGLES, two per quad of a lattice that
+// is slices quads around and slices / 2 from the north pole to the south pole.
+layout (location = 3) in mat4 M; // per instance, uses locations 3 to 6
+layout (location = 7) in vec2 material; // per instance, texture array layer and 1 for the sun
+
+// shared by every program, see UniformBuffer.h
+layout (std140) uniform Frame {
+	mat4 V;
+	mat4 P;
+	vec3 lightPosition;
+};
+
+uniform vec3 light = vec3(0.0f, 0.0f, 0.0f);
+uniform int slices;
+
+out vec3 fragPos;
+out vec2 fragColor;
+out vec3 n;
+out vec3 fragLight;
+out float fragSun;
+flat out int fragLayer;
+
+const float PI = 3.14159265358979;
+
+// lattice steps (down, around) to each corner of a quad, counter clockwise from outside
+const ivec2 CORNERS[6] = ivec2[6](
+	ivec2(0, 0), ivec2(1, 0), ivec2(0, 1),
+	ivec2(1, 0), ivec2(1, 1), ivec2(0, 1)
+);
+
+void main() {
+	int stacks = slices / 2;
+	int quad = gl_VertexID / 6;
+	ivec2 corner = CORNERS[gl_VertexID % 6];
+
+	// same mapping as the icospheres: u = atan(-z, x) / 2pi, v = acos(y) / pi
+	float u = float(quad % slices + corner.y) / float(slices);
+	float v = float(quad / slices + corner.x) / float(stacks);
+	float theta = PI * v;
+	float phi = 2.0 * PI * u;
+	vec3 pos = vec3(sin(theta) * cos(phi), cos(theta), -sin(theta) * sin(phi));
+
+	fragSun = material.y;
+	fragLayer = int(material.x);
+	fragLight = light;
+	fragPos = vec3(M * vec4(pos, 1.0));
+	fragColor = vec2(u, v);
+	n = fragPos - vec3(M * vec4(0.0, 0.0, 0.0, 1.0));
+	gl_Position = P * V * M * vec4(pos, 1.0);
+}
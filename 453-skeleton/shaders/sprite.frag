@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec3 fragColor;
+
+out vec4 color;
+
+void main() {
+	// round sprite instead of a square point
+	vec2 c = 2.0 * gl_PointCoord - 1.0;
+	if (dot(c, c) > 1.0) {
+		discard;
+	}
+	color = vec4(fragColor, 1.0);
+}
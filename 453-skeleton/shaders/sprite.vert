@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 color;
+layout (location = 2) in float size;
+
+// shared by every program, see UniformBuffer.h
+layout (std140) uniform Frame {
+	mat4 V;
+	mat4 P;
+	vec3 lightPosition;
+};
+
+out vec3 fragColor;
+
+void main() {
+	fragColor = color;
+	gl_Position = P * V * vec4(pos, 1.0);
+	gl_PointSize = size;
+}
@@ -6,7 +6,12 @@ in vec3 n;
 in vec3 fragLight;
 in float fragSun;
 
-uniform vec3 lightPosition;
+// shared by every program, see UniformBuffer.h
+layout (std140) uniform Frame {
+	mat4 V;
+	mat4 P;
+	vec3 lightPosition;
+};
 
 out vec4 color;
 uniform sampler2D sampler;
@@ -3,13 +3,22 @@ layout (location = 0) in vec3 pos;
 layout (location = 1) in vec2 color;
 layout (location = 2) in vec3 normal;
 
-uniform mat4 M;
-uniform mat4 V;
-uniform mat4 P;
+// shared by every program, see UniformBuffer.h
+layout (std140) uniform Frame {
+	mat4 V;
+	mat4 P;
+	vec3 lightPosition;
+};
+
+// one per draw
+layout (std140) uniform Object {
+	mat4 M;
+	vec3 center;
+	float sun;
+};
+
 uniform mat3 Norm;
 uniform vec3 light = vec3(0.0f, 0.0f, 0.0f);
-uniform float sun;
-uniform vec3 center;
 
 out vec3 fragPos;
 out vec2 fragColor;